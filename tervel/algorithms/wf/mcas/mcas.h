@@ -60,7 +60,7 @@ inline T read(std::atomic<T> *address) {
 template<class T>
 class MultiWordCompareAndSwap : public util::OpRecord {
  public:
-  static constexpr void * MCAS_FAIL_CONST = reinterpret_cast<void *>(0x1L);
+  static void * const MCAS_FAIL_CONST;
 
   explicit MultiWordCompareAndSwap<T>(int max_rows)
       : cas_rows_(new CasRow<T>[max_rows])
@@ -204,6 +204,10 @@ class MultiWordCompareAndSwap : public util::OpRecord {
   friend CasRow<T>;
 };  // MCAS class
 
+template<class T>
+void * const MultiWordCompareAndSwap<T>::MCAS_FAIL_CONST =
+    reinterpret_cast<void *>(0x1L);
+
 
 }  // namespace mcas
 }  // namespace wf
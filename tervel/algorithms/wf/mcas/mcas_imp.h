@@ -62,6 +62,9 @@ bool MultiWordCompareAndSwap<T>::add_cas_triple(std::atomic<T> *address, T expec
         cas_rows_[row_count_].expected_value_ = nullptr;
         cas_rows_[row_count_].new_value_ = nullptr;
         return false;
+      } else {
+        /* The rows before it are already in order */
+        break;
       }
     }
     return true;
@@ -0,0 +1,308 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef TERVEL_CONTAINERS_LF_LINKED_LIST_QUEUE_QUEUE_H_
+#define TERVEL_CONTAINERS_LF_LINKED_LIST_QUEUE_QUEUE_H_
+
+#include <atomic>
+#include <assert.h>
+#include <stddef.h>
+
+#include <tervel/util/info.h>
+#include <tervel/util/util.h>
+#include <tervel/util/padded_atomic.h>
+#include <tervel/util/sharded_counter.h>
+#include <tervel/util/memory/node_pool.h>
+#include <tervel/util/memory/hp/hp_element.h>
+#include <tervel/util/memory/hp/hazard_pointer.h>
+
+namespace tervel {
+namespace containers {
+namespace lf {
+
+/**
+ * @brief An unbounded FIFO queue of linked nodes, the lock-free queue of
+ * Michael and Scott.
+ *
+ * @details The list always contains a dummy node, head_ points to it and the
+ * value of a dequeue is held by the node after it, which becomes the new
+ * dummy. tail_ points to the last or next to last node, any thread which
+ * sees it lag behind moves it forward.
+ *
+ * Nodes are protected by hazard pointers and freed with safe_delete, their
+ * memory is taken from and returned to the thread's NodePool.
+ *
+ * @tparam T The type of information stored, it is copied in and out.
+ */
+template<typename T>
+class Queue {
+ public:
+  class Node;
+  class Accessor;
+
+  Queue();
+  ~Queue();
+
+  /**
+   * @brief Enqueues the value at the end of the queue.
+   *
+   * @param value The value to enqueue.
+   * @return true, the queue is never full.
+   */
+  bool enqueue(T value);
+
+  /**
+   * @brief Dequeues the value at the front of the queue.
+   *
+   * @param access An accessor which receives the dequeued value, see
+   * Accessor::value.
+   * @return whether or not a value was dequeued.
+   */
+  bool dequeue(Accessor &access);
+
+  /**
+   * @return whether or not the queue was empty when checked.
+   */
+  bool empty();
+
+  /**
+   * @return the number of values in the queue.
+   */
+  int64_t size() {
+    return current_size_.load();
+  }
+
+ private:
+  // Each is padded to a cache line, so enqueues, which update tail_, and
+  // dequeues, which update head_, do not contend for one.
+  util::PaddedAtomic<Node *> head_;
+  util::PaddedAtomic<Node *> tail_;
+  util::SizeCounter current_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(Queue);
+};  // class Queue
+
+/**
+ * This defines the Node class. This class extends the "Element" class,
+ * enabling the use of hazard pointers with Node objects. Nodes are allocated
+ * from the thread's NodePool.
+ */
+template<typename T>
+class Queue<T>::Node : public tervel::util::memory::hp::Element {
+ public:
+  Node() {};
+  explicit Node(const T &v) : val_(v) {};
+  ~Node() {};
+
+  static void * operator new(size_t size) {
+    return tervel::util::memory::NodePool::allocate(size);
+  }
+
+  static void operator delete(void *ptr, size_t size) {
+    tervel::util::memory::NodePool::release(ptr, size);
+  }
+
+  T value() { return val_; };
+  Node *next() { return next_.load(); };
+  std::atomic<Node *> *next_address() { return &next_; };
+  bool cas_next(Node *expected, Node *n) {
+    return next_.compare_exchange_strong(expected, n);
+  };
+
+ private:
+  T val_ {};
+  std::atomic<Node *> next_ {nullptr};
+};
+
+/**
+  * This defines the Accessor class, it holds the hazard pointer watches an
+  * operation needs on a node and its successor, and the value of a dequeue.
+  *
+  * The watches are removed by unaccess and when the accessor is destroyed.
+  */
+template<typename T>
+class Queue<T>::Accessor {
+ public:
+  typedef tervel::util::memory::hp::HazardPointer::SlotID SlotID;
+  static const SlotID node_pos = SlotID::SHORTUSE;
+  static const SlotID next_pos = SlotID::SHORTUSE2;
+
+  Accessor() {};
+  ~Accessor() {
+    unaccess();
+  };
+
+/**
+  * Watches the node stored at address.
+  *
+  * @param address Address of the std::atomic<Node *> to be loaded.
+  * @return true if the node was watched while still stored at address.
+  */
+  bool load(std::atomic<Node *> *address) {
+    Node *element = address->load();
+    if (tervel::util::memory::hp::HazardPointer::watch(node_pos,
+          reinterpret_cast<void *>(element),
+          reinterpret_cast<std::atomic<void *> *>(address), element)) {
+      node_ = element;
+      return true;
+    }
+    return false;
+  };
+
+/**
+  * Watches the successor of the loaded node, it is only protected once the
+  * caller has checked that the loaded node is still the head or tail.
+  *
+  * @return the successor, which may be nullptr.
+  */
+  Node * load_next() {
+    Node *element = node_->next();
+    if (element != nullptr) {
+      tervel::util::memory::hp::HazardPointer::watch(next_pos,
+          reinterpret_cast<void *>(element),
+          reinterpret_cast<std::atomic<void *> *>(node_->next_address()),
+          element);
+    }
+    next_ = element;
+    return element;
+  };
+
+/**
+  * Removes the watches placed by load and load_next.
+  */
+  void unaccess() {
+    tervel::util::memory::hp::HazardPointer::unwatch(node_pos);
+    tervel::util::memory::hp::HazardPointer::unwatch(next_pos);
+    node_ = nullptr;
+    next_ = nullptr;
+  };
+
+/**
+  * @return the value of the last successful dequeue using this accessor.
+  */
+  T value() { return val_; };
+
+  Node * ptr() { return node_; };
+  Node * next_ptr() { return next_; };
+
+ private:
+  Node *node_ {nullptr};
+  Node *next_ {nullptr};
+  T val_ {};
+  friend class Queue<T>;
+};
+
+template<typename T>
+Queue<T>::Queue() {
+  Node *dummy = new Node();
+  head_.store(dummy);
+  tail_.store(dummy);
+}
+
+template<typename T>
+Queue<T>::~Queue() {
+  Node *cur = head_.load();
+  while (cur != nullptr) {
+    Node *next = cur->next();
+    delete cur;
+    cur = next;
+  }
+}
+
+template<typename T>
+bool Queue<T>::enqueue(T value) {
+  Node *elem = new Node(value);
+
+  while (true) {
+    Accessor access;
+    if (access.load(&tail_.atomic) == false) {
+      continue;
+    }
+
+    // The next of the last node is only written once, so it may be read
+    // without a watch.
+    Node *tail = access.ptr();
+    Node *next = tail->next();
+    if (next != nullptr) {
+      // tail_ lags behind, move it forward and retry.
+      tail_.compare_exchange_strong(tail, next);
+    } else if (tail->cas_next(nullptr, elem)) {
+      tail_.compare_exchange_strong(tail, elem);
+      current_size_.add(1);
+      return true;
+    }
+  }  // while (true)
+}  // bool enqueue(T value)
+
+template<typename T>
+bool Queue<T>::dequeue(Accessor &access) {
+  while (true) {
+    access.unaccess();
+    if (access.load(&head_.atomic) == false) {
+      continue;
+    }
+
+    Node *head = access.ptr();
+    Node *next = access.load_next();
+    // next is protected only if it has not been dequeued since it was
+    // watched, which is the case while head is still the head.
+    if (head_.load() != head) {
+      continue;
+    }
+
+    if (next == nullptr) {
+      access.unaccess();
+      return false;
+    }
+
+    Node *tail = tail_.load();
+    if (head == tail) {
+      // Do not let the head pass the tail, whose node would be freed.
+      tail_.compare_exchange_strong(tail, next);
+      continue;
+    }
+
+    T value = next->value();
+    if (head_.compare_exchange_strong(head, next)) {
+      access.val_ = value;
+      access.unaccess();
+      head->safe_delete();
+      current_size_.add(-1);
+      return true;
+    }
+  }  // while (true)
+}  // bool dequeue(Accessor &access)
+
+template<typename T>
+bool Queue<T>::empty() {
+  Accessor access;
+  while (access.load(&head_.atomic) == false) {}
+  return access.ptr()->next() == nullptr;
+}
+
+}  // namespace lf
+}  // namespace containers
+}  // namespace tervel
+
+#endif  // TERVEL_CONTAINERS_LF_LINKED_LIST_QUEUE_QUEUE_H_
@@ -35,14 +35,51 @@ THE SOFTWARE.
 
 #include <tervel/util/info.h>
 #include <tervel/util/util.h>
+#include <tervel/util/elimination_array.h>
 #include <tervel/util/progress_assurance.h>
 #include <tervel/util/memory/hp/hp_element.h>
 #include <tervel/util/memory/hp/hazard_pointer.h>
 
+#ifdef TERVEL_STACK_LF_WAIT_FREE
+#include <tervel/containers/wf/stack/stack.h>
+#endif
+
 namespace tervel {
 namespace containers {
 namespace lf {
 
+#ifdef TERVEL_STACK_LF_WAIT_FREE
+/**
+ * The stack used when TERVEL_STACK_LF_WAIT_FREE is defined, which falls back
+ * to announcing an operation once it has failed TERVEL_PROG_ASSUR_LIMIT
+ * times, so that it is wait-free.
+ *
+ * An announced operation places a helper at the head, which every other
+ * operation must recognise and complete, and every operation must check for
+ * announcements. That is wf::Stack's algorithm, so this stores a wf::Stack
+ * and forwards to it.
+ */
+template<typename T>
+class Stack {
+ public:
+  Stack() {};
+  ~Stack() {};
+
+  bool push(T v) {
+    return stack_.push(v);
+  }
+
+  bool pop(T &v) {
+    return stack_.pop(v);
+  }
+
+ private:
+  wf::Stack<T> stack_;
+
+  DISALLOW_COPY_AND_ASSIGN(Stack);
+};  // class Stack
+#else  // !TERVEL_STACK_LF_WAIT_FREE
+
 // TOTAL Dev time: 2 hours 12 minutes
 template<typename T>
 class Stack {
@@ -57,6 +94,10 @@ class Stack {
   bool pop(T &v);
  private:
   std::atomic<Node *> _stack __attribute__((aligned(CACHE_LINE_SIZE)));
+#ifdef TERVEL_STACK_ELIMINATION
+  // Pairs a push and a pop which fail to update _stack at the same time.
+  util::EliminationArray<T> _elimination;
+#endif
 };  // class Stack
 
 /**
@@ -164,6 +205,13 @@ bool Stack<T>::push(T v) {
     if (_stack.compare_exchange_strong(cur, elem)) {
       return true;
     }
+#ifdef TERVEL_STACK_ELIMINATION
+    // elem was never reachable from _stack, so it is freed directly.
+    if (_elimination.offer(v)) {
+      delete elem;
+      return true;
+    }
+#endif
   }  // while (true)
 }  // bool push(T v)
 
@@ -196,6 +244,11 @@ bool Stack<T>::pop(T& v) {
       cur->safe_delete();
       return true;
     }
+#ifdef TERVEL_STACK_ELIMINATION
+    else if (_elimination.take(v)) {
+      return true;
+    }
+#endif
   }  // while (true)
 }  // bool pop(T v)
 
@@ -216,6 +269,7 @@ class __attribute__((aligned(CACHE_LINE_SIZE))) Stack<T>::Node : public tervel::
   T _val;
   Node *_next {nullptr};
 };
+#endif  // TERVEL_STACK_LF_WAIT_FREE
 
 }  // namespace LF
 }  // namespace containers
@@ -0,0 +1,285 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef TERVEL_CONTAINER_WF_HASH_MAP_SNAPSHOT_H_
+#define TERVEL_CONTAINER_WF_HASH_MAP_SNAPSHOT_H_
+
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <tervel/util/util.h>
+
+namespace tervel {
+namespace containers {
+namespace wf {
+
+/**
+ * The on disk layout of a hash map snapshot, version 1:
+ *
+ *   SnapshotHeader
+ *   count records, each the hashed key followed by the value, packed
+ *
+ * Keys and values are stored in the native representation of the machine
+ * that wrote them, a snapshot is not portable between architectures.
+ *
+ * Records are written in the order a depth first walk of the hash map visits
+ * them, which orders them by the bits of their hashed keys. A map of any
+ * geometry therefore finds the records that belong to each of its primary
+ * positions stored contiguously, which lets them be loaded in parallel
+ * without sorting.
+ */
+struct SnapshotHeader {
+  static const uint32_t kVersion = 1;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t key_size;
+  uint32_t value_size;
+  uint32_t reserved;
+  uint64_t count;
+};
+
+static const char kSnapshotMagic[8] = {'T', 'V', 'L', 'H', 'M', 'A', 'P', 0};
+
+/**
+ * Writes a snapshot file, see SnapshotHeader.
+ */
+template<class Key, class Value>
+class SnapshotWriter {
+  static_assert(std::is_trivially_copyable<Key>::value &&
+        std::is_trivially_copyable<Value>::value,
+        "Snapshots require trivially copyable keys and values");
+
+ public:
+  SnapshotWriter() {}
+
+  ~SnapshotWriter() {
+    if (file_ != nullptr) {
+      fclose(file_);
+    }
+  }
+
+  /**
+   * Creates the file at path and writes a header with a count of zero.
+   * @return whether or not the file was created
+   */
+  bool open(const std::string &path) {
+    file_ = fopen(path.c_str(), "wb");
+    if (file_ == nullptr) {
+      return false;
+    }
+    SnapshotHeader header = make_header(0);
+    return fwrite(&header, sizeof(header), 1, file_) == 1;
+  }
+
+  /**
+   * Appends a record to the file. The file is buffered, a record does not
+   * result in a system call.
+   */
+  void append(const Key &key, const Value &value) {
+    ok_ = ok_ && fwrite(&key, sizeof(Key), 1, file_) == 1;
+    ok_ = ok_ && fwrite(&value, sizeof(Value), 1, file_) == 1;
+    count_++;
+  }
+
+  /**
+   * Records the number of records in the header and closes the file.
+   * @return whether or not every write succeeded
+   */
+  bool close() {
+    SnapshotHeader header = make_header(count_);
+    ok_ = ok_ && fseek(file_, 0, SEEK_SET) == 0;
+    ok_ = ok_ && fwrite(&header, sizeof(header), 1, file_) == 1;
+    ok_ = (fclose(file_) == 0) && ok_;
+    file_ = nullptr;
+    return ok_;
+  }
+
+ private:
+  static SnapshotHeader make_header(uint64_t count) {
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+    header.version = SnapshotHeader::kVersion;
+    header.key_size = sizeof(Key);
+    header.value_size = sizeof(Value);
+    header.count = count;
+    return header;
+  }
+
+  FILE *file_ {nullptr};
+  uint64_t count_ {0};
+  bool ok_ {true};
+  DISALLOW_COPY_AND_ASSIGN(SnapshotWriter);
+};  // class SnapshotWriter
+
+/**
+ * Maps a snapshot file into memory and provides access to its records.
+ */
+template<class Key, class Value>
+class SnapshotReader {
+  static_assert(std::is_trivially_copyable<Key>::value &&
+        std::is_trivially_copyable<Value>::value,
+        "Snapshots require trivially copyable keys and values");
+
+ public:
+  SnapshotReader() {}
+
+  ~SnapshotReader() {
+    if (data_ != nullptr) {
+      munmap(data_, length_);
+    }
+  }
+
+  /**
+   * Maps the file at path.
+   * @return false if the file could not be mapped, or is not a snapshot of
+   *   the same version, key size and value size.
+   */
+  bool open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 ||
+          static_cast<size_t>(file_stat.st_size) < sizeof(SnapshotHeader)) {
+      ::close(fd);
+      return false;
+    }
+    length_ = file_stat.st_size;
+    void *data = mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      return false;
+    }
+    data_ = reinterpret_cast<char *>(data);
+    madvise(data_, length_, MADV_SEQUENTIAL);
+
+    SnapshotHeader header;
+    memcpy(&header, data_, sizeof(header));
+    if (memcmp(header.magic, kSnapshotMagic, sizeof(header.magic)) != 0 ||
+          header.version != SnapshotHeader::kVersion ||
+          header.key_size != sizeof(Key) ||
+          header.value_size != sizeof(Value) ||
+          header.count > (length_ - sizeof(header)) / kRecordSize) {
+      return false;
+    }
+    count_ = header.count;
+    return true;
+  }
+
+  /**
+   * @return the number of records in the snapshot
+   */
+  uint64_t count() {
+    return count_;
+  }
+
+  /**
+   * Copies out the record at idx.
+   */
+  void record(uint64_t idx, Key *key, Value *value) {
+    assert(idx < count_);
+    const char *pos = data_ + sizeof(SnapshotHeader) + idx * kRecordSize;
+    memcpy(key, pos, sizeof(Key));
+    memcpy(value, pos + sizeof(Key), sizeof(Value));
+  }
+
+  /**
+   * Splits the records into up to num_threads ranges of about equal size such
+   * that the records of a primary position are all in one range.
+   *
+   * @param position: returns the primary position of a record's key
+   * @return the boundaries of the ranges, range i is [result[i], result[i+1])
+   */
+  template<class PositionFunction>
+  std::vector<uint64_t> partition(size_t num_threads,
+        PositionFunction position) {
+    std::vector<uint64_t> bounds(1, 0);
+    for (size_t t = 1; t < num_threads; t++) {
+      uint64_t idx = count_ * t / num_threads;
+      if (idx <= bounds.back()) {
+        continue;
+      }
+      Key key;
+      Value value;
+      record(idx - 1, &key, &value);
+      const uint64_t prev = position(key);
+      while (idx < count_) {
+        record(idx, &key, &value);
+        if (position(key) != prev) {
+          break;
+        }
+        idx++;
+      }
+      if (idx > bounds.back() && idx < count_) {
+        bounds.push_back(idx);
+      }
+    }
+    bounds.push_back(count_);
+    return bounds;
+  }
+
+ private:
+  static const size_t kRecordSize = sizeof(Key) + sizeof(Value);
+
+  char *data_ {nullptr};
+  size_t length_ {0};
+  uint64_t count_ {0};
+  DISALLOW_COPY_AND_ASSIGN(SnapshotReader);
+};  // class SnapshotReader
+
+/**
+ * Runs work(i) for i in [0, num_threads), using the calling thread for i = 0,
+ * and waits for all of them to finish.
+ */
+template<class Work>
+void run_in_parallel(size_t num_threads, Work work) {
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < num_threads; t++) {
+    threads.emplace_back(work, t);
+  }
+  work(0);
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace wf
+}  // namespace containers
+}  // namespace tervel
+
+#endif  // TERVEL_CONTAINER_WF_HASH_MAP_SNAPSHOT_H_
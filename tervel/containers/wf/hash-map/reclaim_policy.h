@@ -0,0 +1,111 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef TERVEL_CONTAINER_WF_HASH_MAP_RECLAIM_POLICY_H_
+#define TERVEL_CONTAINER_WF_HASH_MAP_RECLAIM_POLICY_H_
+
+#include <atomic>
+
+#include <stdint.h>
+
+#include <tervel/util/util.h>
+
+namespace tervel {
+namespace containers {
+namespace wf {
+
+/**
+ * The reclamation policy of a HashMap that supports remove.
+ *
+ * Nodes are read under hazard pointer watches and each data node carries an
+ * access counter guarding its value, so a removed or collapsed node is freed
+ * once no thread references it.
+ */
+struct HazardPointerReclaim {
+  static const bool kReclaims = true;
+};
+
+/**
+ * The reclamation policy of a HashMap that only grows.
+ *
+ * Nodes are freed only by the hash map's destructor, so references are read
+ * without hazard pointer watches, data nodes carry no access counter, and
+ * insert and at are bounded without progress assurance. remove and compact
+ * are unavailable.
+ */
+struct NoReclaim {
+  static const bool kReclaims = false;
+};
+
+/**
+ * The base of a node of a hash map that does not reclaim nodes, in place of
+ * the hazard pointer Element.
+ */
+class unreclaimed_node {
+ public:
+  unreclaimed_node() {}
+  virtual ~unreclaimed_node() {}
+
+  /**
+   * Nodes are only retired by paths that follow a remove or a compact, which
+   * are unavailable without reclamation, so this is never reached while the
+   * hash map is shared.
+   */
+  void safe_delete() {
+    delete this;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(unreclaimed_node);
+};
+
+/**
+ * The access counter of a data node. A negative count marks the node as
+ * logically deleted.
+ */
+template<bool kReclaims>
+class access_counter {
+ public:
+  access_counter() : access_count_(0) {}
+
+  bool is_deleted(std::memory_order order = std::memory_order_seq_cst) {
+    return access_count_.load(order) < 0;
+  }
+
+  std::atomic<int64_t> access_count_;
+};
+
+template<>
+class access_counter<false> {
+ public:
+  bool is_deleted(std::memory_order = std::memory_order_seq_cst) {
+    return false;
+  }
+};
+
+}  // namespace wf
+}  // namespace containers
+}  // namespace tervel
+
+#endif  // TERVEL_CONTAINER_WF_HASH_MAP_RECLAIM_POLICY_H_
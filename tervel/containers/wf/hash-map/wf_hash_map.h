@@ -26,10 +26,20 @@ THE SOFTWARE.
 #define TERVEL_CONTAINER_WF_HASH_MAP_WFHM_HASHMAP_H
 
 #include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <tervel/containers/wf/hash-map/hash_map_snapshot.h>
+#include <tervel/containers/wf/hash-map/reclaim_policy.h>
 #include <tervel/util/info.h>
 #include <tervel/util/memory/hp/hp_element.h>
 #include <tervel/util/memory/hp/hazard_pointer.h>
+#include <tervel/util/memory/node_pool.h>
 #include <tervel/util/progress_assurance.h>
+#include <tervel/util/sharded_counter.h>
 
 // TODO(Steven):
 //
@@ -58,6 +68,92 @@ struct default_functor {
   }
 };
 
+/**
+ * A fixed width digest of a variable length key.
+ *
+ * @tparam kWords: the width of the digest in 64 bit words.
+ */
+template<size_t kWords>
+struct key_digest {
+  static_assert(kWords > 0, "A digest must be at least one word wide");
+
+  bool operator==(const key_digest &other) const {
+    for (size_t i = 0; i < kWords; i++) {
+      if (words[i] != other.words[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  uint64_t words[kWords];
+};
+
+/**
+ * A Functor for keys which are sequences of bytes, such as std::string or
+ * std::vector<char>. Key must provide data() and size().
+ *
+ * The map navigates by a kDigestWords * 64 bit digest of each key and keeps
+ * the key itself in its data node for equality checks. Two keys with the same
+ * digest can not both be held, the insert of the second will fail, so the
+ * digest should be wide enough that this does not occur in practice.
+ */
+template<class Key, class Value, size_t kDigestWords = 2>
+struct string_functor {
+  key_digest<kDigestWords> hash(const Key &k) {
+    const char *bytes = reinterpret_cast<const char *>(k.data());
+    const size_t length = k.size() * sizeof(*k.data());
+
+    key_digest<kDigestWords> digest;
+    for (size_t w = 0; w < kDigestWords; w++) {
+      uint64_t h = (0x9E3779B97F4A7C15ULL * (w + 1)) ^ length;
+      size_t i = 0;
+      for (; i + 8 <= length; i += 8) {
+        uint64_t chunk;
+        memcpy(&chunk, bytes + i, 8);
+        h = mix(h ^ chunk);
+      }
+      uint64_t tail = 0;
+      memcpy(&tail, bytes + i, length - i);
+      digest.words[w] = mix(mix(h ^ tail));
+    }
+    return digest;
+  }
+
+  bool key_equals(const Key &a, const Key &b) {
+    return a == b;
+  }
+
+ private:
+  // The finalizer of MurmurHash3, it spreads every input bit to the high bits
+  // that select positions in the map.
+  static uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+};
+
+/**
+ * Holds the original key of a data node when the map navigates by a digest
+ * that differs from the key type. Empty otherwise.
+ */
+template<class Key, bool kStoresKey>
+class stored_key {
+ public:
+  explicit stored_key(const Key &key) : full_key_(key) {}
+  Key full_key_;
+};
+
+template<class Key>
+class stored_key<Key, false> {
+ public:
+  explicit stored_key(const Key &) {}
+};
+
 
 
 /**
@@ -70,17 +166,62 @@ struct default_functor {
  *   -bool key_equals (Key a, Key b)
  *       Important Note: the hashed value of keys will be passed in.
  *
+ * For keys that are not fixed width, such as strings, hash may instead return
+ * a fixed width Digest type (see string_functor). The map then navigates by
+ * the digest, stores the original key in the data node, and key_equals is
+ * passed the original keys. Digest must be a multiple of 64 bits wide and
+ * provide operator==.
+ *
+ * Array nodes that are left holding zero or one entries can be collapsed back
+ * into their parent position, see compact(). A collapse freezes every position
+ * of the array node by setting the least significant bit of its reference,
+ * after which the array node is immutable and any thread that encounters a
+ * frozen position helps complete the collapse before retrying.
+ *
+ * ReclaimPolicy selects how nodes are protected, see reclaim_policy.h. With
+ * NoReclaim the hash map only grows: remove and compact are unavailable and
+ * the hazard pointer watches and access counting are compiled out.
+ * HashMapNoDelete names that configuration.
  */
-template< class Key, class Value, class Functor = default_functor<Key, Value> >
+template< class Key, class Value, class Functor = default_functor<Key, Value>,
+      class ReclaimPolicy = HazardPointerReclaim >
 class HashMap {
  public:
   class ValueAccessor;
+  struct Statistics;
+
+  /**
+   * The type the map navigates by, the result of Functor::hash.
+   */
+  typedef decltype(std::declval<Functor>().hash(std::declval<Key>())) Digest;
+
+  /**
+   * True if Digest differs from Key, in which case each data node also holds
+   * the original key.
+   */
+  static const bool kStoresKey = !std::is_same<Digest, Key>::value;
+
+  /**
+   * False if the hash map never frees nodes before its destruction, see
+   * NoReclaim.
+   */
+  static const bool kReclaims = ReclaimPolicy::kReclaims;
 
-  HashMap(uint64_t capacity, uint64_t expansion_rate = 3)
-    : primary_array_size_(tervel::util::round_to_next_power_of_two(capacity))
+  /**
+   * @param capacity: the number of positions in the primary array, rounded up
+   *   to a power of two of at least 2.
+   * @param expansion_rate: the size of an array node is 2^expansion_rate.
+   * @param compact_on_remove: if true then a remove which leaves an array node
+   *   holding one or fewer entries will attempt to collapse it.
+   */
+  HashMap(uint64_t capacity, uint64_t expansion_rate = 3,
+        bool compact_on_remove = true)
+    : primary_array_size_(uint64_t(1) << tervel::util::round_to_next_power_of_two(
+          std::max<uint64_t>(capacity, 2)))
     , primary_array_pow_(std::log2(primary_array_size_))
     , secondary_array_size_(std::pow(2, expansion_rate))
     , secondary_array_pow_(expansion_rate)
+    , compact_on_remove_(compact_on_remove)
     , primary_array_(new Location[primary_array_size_]()) { }
 
   /**
@@ -88,16 +229,13 @@ class HashMap {
    * May create a very large stack!
    *   Note: should implement a better way...
    *   If it is a node type then the node will be freed
-   *   If it is an array node then the destructor of the array node will free
-   *     any nodes that are referenced it. This may cause more array node's to
-   *     be freed. Stack can reach max_depth() in size.
+   *   If it is an array node then each node it references is freed first,
+   *     including those behind frozen positions of an unfinished collapse.
+   *     Stack can reach max_depth() in size.
    */
   ~HashMap() {
     for (size_t i = 0; i < primary_array_size_; i++) {
-      Node * temp = primary_array_[i].load();
-      if (temp != nullptr) {
-        delete temp;
-      }
+      free_node(primary_array_[i].load());
     }
   }  // ~ HashMap
 
@@ -138,11 +276,35 @@ class HashMap {
    * Returns false in the event the key is not in the hash map or if the
    * access_counter is non-zero.
    *
+   * Requires a reclaiming ReclaimPolicy.
+   *
    * @param key: The key to resume
    * @return where or not the key was removed
    */
   bool remove(Key key);
 
+  /**
+   * Inserts each key/value pair in [begin, end), as if by insert, using
+   * num_threads threads.
+   *
+   * Not Thread Safe! The hash map must not be accessed by any other thread
+   * until this function returns, for example while filling it at startup.
+   * Keys are grouped by their primary array position and each thread builds
+   * the subtrees of a range of positions without atomic read-modify-writes,
+   * hazard pointers or progress assurance. The subtrees are published once
+   * all threads have finished. If a key occurs more than once then its first
+   * occurrence is kept, as a sequence of inserts would.
+   *
+   * @param begin: a random access iterator to std::pair<Key, Value> like
+   *   elements
+   * @param end: the end of the range
+   * @param num_threads: the number of threads to build with, including the
+   *   calling thread
+   * @return the number of key/value pairs inserted
+   */
+  template<class Iterator>
+  uint64_t bulk_load(Iterator begin, Iterator end, size_t num_threads = 1);
+
   /**
    * @return the number of keys in the hash map
    */
@@ -150,6 +312,97 @@ class HashMap {
     return size_.load();
   };
 
+  /**
+   * @return the number of keys in the hash map, which may not include recent
+   *   inserts and removes if TERVEL_SHARDED_SIZE is defined.
+   */
+  size_t approximate_size() {
+    return size_.approximate();
+  }
+
+  /**
+   * Walks the hash map and collapses every array node which holds one or fewer
+   * entries and no array nodes into its parent position. Children are visited
+   * before their parents, so a chain of sparse array nodes collapses in a
+   * single call. Logically deleted data nodes are dropped and retired.
+   *
+   * This function is lock-free and may be called concurrently with any other
+   * operation. Requires a reclaiming ReclaimPolicy.
+   */
+  void compact();
+
+  /**
+   * Weakly consistent depth and occupancy information, gathered by a walk of
+   * the hash map. It may be called concurrently with any other operation.
+   *
+   * @return the statistics gathered.
+   */
+  Statistics statistics();
+
+  /**
+   * Writes the key/value pairs of the hash map to a file at path, see
+   * hash_map_snapshot.h for its layout. The hash map is walked as by
+   * statistics(), so a snapshot taken concurrently with other operations is
+   * weakly consistent. Requires trivially copyable keys and values which are
+   * their own digest.
+   *
+   * @param path: the file to create
+   * @return whether or not the snapshot was written
+   */
+  bool save_snapshot(const std::string &path);
+
+  /**
+   * Inserts the key/value pairs of a snapshot written by save_snapshot, with
+   * the same requirements and semantics as bulk_load. The file is memory
+   * mapped and its records are read directly, each thread building the
+   * subtrees of a range of primary positions.
+   *
+   * Not Thread Safe! See bulk_load.
+   *
+   * @param path: the snapshot file
+   * @param num_threads: the number of threads to build with, including the
+   *   calling thread
+   * @return false if the file is not a snapshot of this key and value type
+   */
+  bool load_snapshot(const std::string &path, size_t num_threads = 1);
+
+  /**
+   * The result of statistics().
+   */
+  struct Statistics {
+    /** The number of array nodes reachable from the primary array. */
+    uint64_t array_nodes {0};
+    /** The number of data nodes that are not logically deleted. */
+    uint64_t data_nodes {0};
+    /** The number of logically deleted data nodes not yet unlinked. */
+    uint64_t deleted_nodes {0};
+    /** The number of positions across all array nodes. */
+    uint64_t array_positions {0};
+    /** The number of those positions which hold nullptr. */
+    uint64_t empty_positions {0};
+    /** The deepest depth a data node was found at (0 is the primary array). */
+    uint64_t max_depth {0};
+    /** The sum of the depths of every data node. */
+    uint64_t depth_sum {0};
+
+    /**
+     * @return the average depth of a data node.
+     */
+    double mean_depth() const {
+      return data_nodes == 0 ? 0.0 :
+          static_cast<double>(depth_sum) / static_cast<double>(data_nodes);
+    }
+
+    /**
+     * @return the fraction of array node positions which are in use.
+     */
+    double occupancy() const {
+      return array_positions == 0 ? 0.0 :
+          1.0 - static_cast<double>(empty_positions) /
+          static_cast<double>(array_positions);
+    }
+  };
+
 
   /**
    * This class is used to safe guard access to values.
@@ -178,7 +431,7 @@ class HashMap {
      * @return whether or not this was initialized.
      */
     bool valid() {
-      return (value_ != nullptr && access_count_ != nullptr);
+      return (value_ != nullptr);
     }
 
     /**
@@ -189,15 +442,16 @@ class HashMap {
       if (access_count_) {
         access_count_->fetch_add(-1);
         access_count_ = nullptr;
-        value_ = nullptr;
       }
+      value_ = nullptr;
     }
 
    private:
     /**
      * Initializes the value accessor.
      * @param value: the address of the value
-     * @param access_count: the address of the value's access_count
+     * @param access_count: the address of the value's access_count, or
+     *   nullptr if the hash map does not reclaim nodes
      */
     void init(Value * value, std::atomic<int64_t> *access_count) {
       if (access_count_) {  // In case they reuse the object
@@ -214,11 +468,11 @@ class HashMap {
 
 
   /**
-   * @param key: The key
+   * @param key: The hashed key
    * @param depth: The depth
    * @return the position this key belongs in at the specified depth.
    */
-  uint64_t get_position(Key &key, size_t depth);
+  uint64_t get_position(Digest &key, size_t depth);
 
   /**
    * @return the maximum depth of the hash map, any depth beyond this would
@@ -237,16 +491,40 @@ class HashMap {
   friend class Node;
   friend class ForceExpandOp;
   typedef std::atomic<Node *> Location;
+  typedef tervel::util::memory::hp::HazardPointer::SlotID SlotID;
 
 
   /**
    * This class is used to differentiate between data_nodes and array_nodes/
+   *
+   * If the hash map reclaims nodes they are allocated from the calling
+   * thread's NodePool, so nodes released by a failed CAS or by safe_delete
+   * are reused by later operations instead of being returned to the
+   * allocator. Otherwise nodes live until the hash map is destroyed and are
+   * allocated directly, without the hazard pointer base or cache line
+   * rounding.
    */
-  class Node : public tervel::util::memory::hp::Element {
+  class Node : public std::conditional<kReclaims,
+      tervel::util::memory::hp::Element, unreclaimed_node>::type {
    public:
     Node() {}
     virtual ~Node() {}
 
+    static void * operator new(size_t size) {
+      if (kReclaims) {
+        return tervel::util::memory::NodePool::allocate(size);
+      }
+      return ::operator new(size);
+    }
+
+    static void operator delete(void *ptr, size_t size) {
+      if (kReclaims) {
+        tervel::util::memory::NodePool::release(ptr, size);
+      } else {
+        ::operator delete(ptr);
+      }
+    }
+
     /**
      * @return whether or not this instance is an ArrayNode sub type
      */
@@ -265,22 +543,27 @@ class HashMap {
    public:
     explicit ArrayNode(uint64_t len)
       : len_(len)
-      , internal_array_(new Location[len]()) {
+      , internal_array_(reinterpret_cast<Location *>(
+            Node::operator new(len * sizeof(Location)))) {
         for (size_t i = 0; i < len_; i++) {
-          internal_array_[i].store(nullptr);
+          new (&internal_array_[i]) Location(nullptr);
         }
       }
 
     /**
      * See Notes on hash map destructor.
+     * Frozen positions are skipped, a collapsed array node is retired while
+     * the nodes it referenced have been moved elsewhere or retired separately.
      */
     ~ArrayNode() {
       for (size_t i = 0; i < len_; i++) {
         Node * temp = internal_array_[i].load();
-        if (temp != nullptr) {
+        if (temp != nullptr && !is_frozen(temp)) {
           delete temp;
         }
       }
+      Node::operator delete(internal_array_,
+            len_ * sizeof(Location));
     }  // ~ArrayNode
 
 
@@ -293,6 +576,13 @@ class HashMap {
       return &(internal_array_[pos]);
     }
 
+    /**
+     * @return the number of positions in the internal array
+     */
+    uint64_t len() {
+      return len_;
+    }
+
     /**
      * @return whether or not this instance is an ArrayNode sub type
      */
@@ -309,19 +599,21 @@ class HashMap {
 
    private:
     uint64_t len_;
-    std::unique_ptr<Location[]> internal_array_;
+    Location * const internal_array_;
   };
 
   /**
    * This class is used to hold a key and value pair.
-   * It is hazard pointer protected.
+   * It is hazard pointer protected and, if the hash map reclaims nodes, its
+   * value is guarded by an access counter.
    */
-  class DataNode : public Node {
+  class DataNode : public Node, public stored_key<Key, kStoresKey>,
+      public access_counter<kReclaims> {
    public:
-    explicit DataNode(Key k, Value v)
-      : key_(k)
-      , value_(v)
-      , access_count_(0) {}
+    DataNode(Digest k, const Key &full_key, Value v)
+      : stored_key<Key, kStoresKey>(full_key)
+      , key_(k)
+      , value_(v) {}
 
     ~DataNode() { }
 
@@ -339,20 +631,25 @@ class HashMap {
       return true;
     }
 
-    Key key_;
+    Digest key_;
     Value value_;
-    std::atomic<int64_t> access_count_;
   };
 
 
   /**
    * TODO(steven): add description
    * TODO(steven): move into a file.
+   *
+   * loc_ is a position of parent_ (or of the primary array if parent_ is
+   * nullptr). Watching this op also watches parent_, so a collapse can not
+   * free it while a helper is expanding loc_.
    */
-  class ForceExpandOp : util::OpRecord {
+  class ForceExpandOp : public util::OpRecord {
     public:
-      ForceExpandOp(HashMap *map, Location *loc, size_t depth)
+      ForceExpandOp(HashMap *map, ArrayNode *parent, Location *loc,
+            size_t depth)
        : map_(map)
+       , parent_(parent)
        , loc_(loc)
        , depth_(depth){}
 
@@ -360,22 +657,47 @@ class HashMap {
         if (depth_ >= map_->max_depth()) {
             return;
         }
-        Node *value = loc_->load();
+        Node *value;
         while (true) {
           if (!map_->hp_watch_and_get_value(loc_,value)) {
              continue;
+          } else if (is_frozen(value)) {
+            // parent_ is being collapsed, the announcing thread will help it.
+            break;
           } else if (value == nullptr || value->is_data()) {
             map_->expand_map(loc_, value, depth_);
-            value = loc_->load();
+            map_->hp_unwatch();
           } else {
+            map_->hp_unwatch();
             break;
           }
         }
       };
 
+      using util::OpRecord::on_watch;
+      bool on_watch(std::atomic<void *> *address, void *expected) {
+        if (parent_ == nullptr) {
+          return true;
+        }
+        map_->hp_watch(SlotID::SHORTUSE3, parent_);
+        if (address->load() != expected) {
+          util::memory::hp::HazardPointer::unwatch(SlotID::SHORTUSE3);
+          return false;
+        }
+        return true;
+      }
+
+      using util::OpRecord::on_unwatch;
+      void on_unwatch() {
+        if (parent_ != nullptr) {
+          util::memory::hp::HazardPointer::unwatch(SlotID::SHORTUSE3);
+        }
+      }
+
     private:
       friend class HashMap;
       HashMap *map_{nullptr};
+      ArrayNode *parent_{nullptr};
       Location *loc_{nullptr};
       size_t depth_{0};
    };
@@ -398,30 +720,271 @@ class HashMap {
    * @return       whether or not it was able to dereference and hazard pointer
    * watch a node object.
    */
-  bool hp_watch_and_get_value(Location * loc, Node * &value);
-  void hp_unwatch();
+  bool hp_watch_and_get_value(Location * loc, Node * &value,
+        SlotID slot = SlotID::SHORTUSE);
+  void hp_unwatch(SlotID slot = SlotID::SHORTUSE);
+
+  /**
+   * Watches a node that is already protected or known to be referenced,
+   * without validation.
+   */
+  void hp_watch(SlotID slot, Node *node) {
+    hp_watch(slot, node, std::integral_constant<bool, kReclaims>());
+  }
+  void hp_watch(SlotID, Node *, std::false_type) {}
+  void hp_watch(SlotID slot, Node *node, std::true_type) {
+    tervel::util::memory::hp::HazardPointer::watch(slot, node);
+  }
+
+  /**
+   * Moves the watch on array_node from SHORTUSE to SHORTUSE2, replacing the
+   * watch on the previous parent. This keeps the array node containing the
+   * next location protected while the traversal reads from it.
+   * @param parent the currently watched parent, updated to array_node
+   * @param array_node the array node watched in SHORTUSE
+   */
+  void hp_descend(ArrayNode * &parent, ArrayNode *array_node);
+
+  /**
+   * @return whether or not a reference has been frozen by a collapse
+   */
+  static bool is_frozen(Node *node) {
+    return tervel::util::is_1st_lsb_1(node);
+  }
+
+  /**
+   * Descends from the primary array following the positions in path, helping
+   * complete any collapse found along the way.
+   * On success the node at loc is watched in SHORTUSE2 and the array node
+   * containing loc is watched in SHORTUSE3 (unless loc is a position of the
+   * primary array).
+   * @param path the position to follow at each depth
+   * @param length the number of positions in path to follow
+   * @param loc set to the location reached
+   * @param value set to the node at loc
+   * @return false, with no watches held, if the path leaves the hash map
+   */
+  bool watch_path(const uint64_t *path, size_t length, Location * &loc,
+        Node * &value);
+
+  /**
+   * Releases the watches acquired by watch_path.
+   */
+  void unwatch_path();
+
+  /**
+   * @param digest: the hash of key
+   * @return whether data_node holds key
+   */
+  bool key_matches(Functor *functor, DataNode *data_node, Digest &digest,
+        Key &key) {
+    return key_matches(functor, data_node, digest, key,
+          std::integral_constant<bool, kStoresKey>());
+  }
+  bool key_matches(Functor *functor, DataNode *data_node, Digest &digest,
+        Key &, std::false_type) {
+    return functor->key_equals(data_node->key_, digest);
+  }
+  bool key_matches(Functor *functor, DataNode *data_node, Digest &digest,
+        Key &key, std::true_type) {
+    return data_node->key_ == digest &&
+        functor->key_equals(data_node->full_key_, key);
+  }
+
+  /**
+   * A data node that holds a different key with the same digest can not be
+   * separated from it by expanding, this detects that case.
+   * @return whether data_node's digest equals digest
+   */
+  bool digest_collides(DataNode *data_node, Digest &digest) {
+    return digest_collides(data_node, digest,
+          std::integral_constant<bool, kStoresKey>());
+  }
+  bool digest_collides(DataNode *, Digest &, std::false_type) {
+    return false;
+  }
+  bool digest_collides(DataNode *data_node, Digest &digest, std::true_type) {
+    return data_node->key_ == digest;
+  }
+
+  /**
+   * Initializes va to reference data_node's value, incrementing its access
+   * counter if the hash map reclaims nodes.
+   * @return false if data_node has been logically deleted
+   */
+  bool acquire_value(DataNode *data_node, ValueAccessor &va) {
+    return acquire_value(data_node, va,
+          std::integral_constant<bool, kReclaims>());
+  }
+  bool acquire_value(DataNode *data_node, ValueAccessor &va, std::false_type) {
+    va.init(&(data_node->value_), nullptr);
+    return true;
+  }
+  bool acquire_value(DataNode *data_node, ValueAccessor &va, std::true_type) {
+    int64_t res = data_node->access_count_.fetch_add(1);
+    if (res >= 0) {  // its not deleted.
+      va.init(&(data_node->value_), &(data_node->access_count_));
+      return true;
+    } else {
+      data_node->access_count_.fetch_add(-1);
+      return false;
+    }
+  }
+
+  /**
+   * @return the positions a key belongs in, from depth 0 to the deepest
+   *   depth its bits reach
+   */
+  std::vector<uint64_t> key_path(Digest &key);
+
+  /**
+   * Helps complete any collapse in progress along the path of key.
+   * @param key: the hashed key
+   */
+  void help_collapse(Digest &key);
+
+  /**
+   * Called by a traversal that found a frozen position: releases the watch on
+   * parent, helps complete the collapse and resets the traversal to the
+   * primary array.
+   */
+  void restart_traversal(Digest &key, size_t &depth, Location * &loc,
+        ArrayNode * &parent);
+
+  /**
+   * Attempts to collapse the array nodes along the path of key, starting with
+   * the one at depth and working up while they continue to collapse.
+   * @param key: the hashed key
+   * @param depth: the depth of the deepest array node to collapse.
+   */
+  void compact_path(Digest &key, size_t depth);
+
+  /**
+   * Collapses every collapsible array node at or below path.
+   */
+  void compact_subtree(std::vector<uint64_t> *path);
+
+  /**
+   * Places the key/value pair in the subtree at loc, which only the calling
+   * thread may access. Used by bulk_load.
+   *
+   * @param digest: the hash of key
+   * @return false if the subtree already holds key
+   */
+  bool bulk_place(Location *loc, Digest &digest, Key &key, Value &value,
+        Functor *functor);
+
+  /**
+   * Calls walk_subtree on each position of the primary array in order, so
+   * visitor sees every node of the hash map. Used by statistics() and
+   * save_snapshot().
+   */
+  template<class Visitor>
+  void walk(Visitor *visitor);
+
+  /**
+   * Visits the nodes at or below path in position order, which is the order
+   * of their hashed keys. visitor->visit_data(data_node, depth) is called
+   * while the data node is watched and visitor->visit_array(array_node,
+   * empty_positions) is called for each array node.
+   */
+  template<class Visitor>
+  void walk_subtree(std::vector<uint64_t> *path, Visitor *visitor);
+
+  /**
+   * Gathers the result of statistics().
+   */
+  struct StatisticsVisitor {
+    void visit_data(DataNode *data_node, uint64_t depth) {
+      if (data_node->is_deleted()) {
+        stats_.deleted_nodes++;
+      } else {
+        stats_.data_nodes++;
+        stats_.depth_sum += depth;
+        stats_.max_depth = std::max(stats_.max_depth, depth);
+      }
+    }
+
+    void visit_array(ArrayNode *array_node, uint64_t empty_positions) {
+      stats_.array_nodes++;
+      stats_.array_positions += array_node->len();
+      stats_.empty_positions += empty_positions;
+    }
+
+    Statistics stats_;
+  };
+
+  /**
+   * Writes each data node that is not logically deleted to a snapshot.
+   */
+  struct SnapshotVisitor {
+    explicit SnapshotVisitor(SnapshotWriter<Digest, Value> *writer)
+      : writer_(writer) {}
+
+    void visit_data(DataNode *data_node, uint64_t) {
+      if (!data_node->is_deleted()) {
+        writer_->append(data_node->key_, data_node->value_);
+      }
+    }
+
+    void visit_array(ArrayNode *, uint64_t) {}
+
+    SnapshotWriter<Digest, Value> * const writer_;
+  };
+
+  /**
+   * Checks if array_node holds one or fewer live entries and no array nodes.
+   * Requires array_node to be watched in SHORTUSE2.
+   * @return whether or not array_node can be collapsed.
+   */
+  bool is_collapsible(ArrayNode *array_node);
+
+  /**
+   * Freezes each position of array_node and replaces it at loc by its only
+   * live entry, by nullptr, or, if an entry was added while freezing, by a
+   * copy of itself. The replaced array node and any logically deleted data
+   * nodes it held are retired through hazard pointers.
+   * Requires array_node to be watched in SHORTUSE2 and the array node
+   * containing loc (if any) to be watched in SHORTUSE3.
+   * @param loc: the location array_node was read from
+   * @param array_node: the array node to collapse
+   * @return whether or not this call replaced array_node
+   */
+  bool collapse(Location *loc, ArrayNode *array_node);
+
+  /**
+   * Not thread safe, frees node and everything it references.
+   */
+  static void free_node(Node *node);
 
   const size_t primary_array_size_;
   const size_t primary_array_pow_;
   const size_t secondary_array_size_;
   const size_t secondary_array_pow_;
+  const bool compact_on_remove_;
 
-  std::atomic<uint64_t> size_;
+  tervel::util::SizeCounter size_;
 
   std::unique_ptr<Location[]> primary_array_;
 };  // class wf hash map
 
 
-static inline bool hp_check_empty() {
-  return !tervel::util::memory::hp::HazardPointer::hasWatch(
-      tervel::util::memory::hp::HazardPointer::SlotID::SHORTUSE);
+static inline bool hp_check_empty(
+      tervel::util::memory::hp::HazardPointer::SlotID slot =
+      tervel::util::memory::hp::HazardPointer::SlotID::SHORTUSE) {
+  return !tervel::util::memory::hp::HazardPointer::hasWatch(slot);
 }
 
 
-template<class Key, class Value, class Functor>
-bool HashMap<Key, Value, Functor>::
-hp_watch_and_get_value(Location * loc, Node * &value) {
-  assert(hp_check_empty());
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+bool HashMap<Key, Value, Functor, ReclaimPolicy>::
+hp_watch_and_get_value(Location * loc, Node * &value, SlotID slot) {
+  if (!kReclaims) {
+    value = loc->load();
+    return true;
+  }
+
+  assert(hp_check_empty(slot));
   std::atomic<void *> *temp_address =
       reinterpret_cast<std::atomic<void *> *>(loc);
 
@@ -430,11 +993,14 @@ hp_watch_and_get_value(Location * loc, Node * &value) {
   if (temp == nullptr) {
     value = nullptr;
     return true;
+  } else if (is_frozen(reinterpret_cast<Node *>(temp))) {
+    // Frozen positions never change and are not dereferenced, no watch needed.
+    value = reinterpret_cast<Node *>(temp);
+    return true;
   }
 
   bool is_watched = tervel::util::memory::hp::HazardPointer::watch(
-        tervel::util::memory::hp::HazardPointer::SlotID::SHORTUSE,
-        temp, temp_address, temp);
+        slot, temp, temp_address, temp);
 
   if (is_watched) {
     value = reinterpret_cast<Node *>(temp);
@@ -445,24 +1011,39 @@ hp_watch_and_get_value(Location * loc, Node * &value) {
   return is_watched;
 }  // hp_watch_and_get_value
 
-template<class Key, class Value, class Functor>
-void HashMap<Key, Value, Functor>::
-hp_unwatch() {
-  tervel::util::memory::hp::HazardPointer::unwatch(
-          tervel::util::memory::hp::HazardPointer::SlotID::SHORTUSE);
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+void HashMap<Key, Value, Functor, ReclaimPolicy>::
+hp_unwatch(SlotID slot) {
+  if (kReclaims) {
+    tervel::util::memory::hp::HazardPointer::unwatch(slot);
+  }
 }  // hp_unwatch
 
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+void HashMap<Key, Value, Functor, ReclaimPolicy>::
+hp_descend(ArrayNode * &parent, ArrayNode *array_node) {
+  if (parent != nullptr) {
+    hp_unwatch(SlotID::SHORTUSE2);
+  }
+  // array_node is already protected by SHORTUSE, so no validation is needed.
+  hp_watch(SlotID::SHORTUSE2, array_node);
+  hp_unwatch(SlotID::SHORTUSE);
+  parent = array_node;
+}  // hp_descend
+
 
-template<class Key, class Value, class Functor>
-bool HashMap<Key, Value, Functor>::
+// Inline so that a caller's consecutive lookups can overlap their misses.
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+inline bool HashMap<Key, Value, Functor, ReclaimPolicy>::
 at(Key key, ValueAccessor &va) {
   assert(hp_check_empty() && " Error: Function Did not release hp watch ");
   Functor functor;
-  key = functor.hash(key);
+  Digest digest = functor.hash(key);
 
   size_t depth = 0;
-  uint64_t position = get_position(key, depth);
+  uint64_t position = get_position(digest, depth);
   Location *loc = &(primary_array_[position]);
+  ArrayNode *parent = nullptr;
   Node *curr_value;
 
 
@@ -470,10 +1051,11 @@ at(Key key, ValueAccessor &va) {
 
   tervel::util::ProgressAssurance::Limit progAssur;
   while (true) {
-    if (progAssur.isDelayed(0)) {
-      ForceExpandOp *op = new ForceExpandOp(this, loc, depth);
+    if (kReclaims && progAssur.isDelayed(0)) {
+      ForceExpandOp *op = new ForceExpandOp(this, parent, loc, depth);
       util::ProgressAssurance::make_announcement(
             reinterpret_cast<tervel::util::OpRecord *>(op));
+      op->safe_delete();
       progAssur.reset();
       continue;
     }
@@ -481,28 +1063,26 @@ at(Key key, ValueAccessor &va) {
     if (!hp_watch_and_get_value(loc, curr_value)) {
       progAssur.isDelayed(1);
       continue;
+    } else if (is_frozen(curr_value)) {
+      // The parent is being collapsed, help it then retry from the top.
+      restart_traversal(digest, depth, loc, parent);
+      progAssur.isDelayed(1);
+      continue;
     } else if (curr_value == nullptr) {
       break;
     } else if (curr_value->is_array()) {
       ArrayNode * array_node = reinterpret_cast<ArrayNode *>(curr_value);
       depth++;
-      position = get_position(key, depth);
+      position = get_position(digest, depth);
       loc = array_node->access(position);
-      hp_unwatch();
+      hp_descend(parent, array_node);
       continue;
     } else {
       assert(curr_value->is_data());
       DataNode * data_node = reinterpret_cast<DataNode *>(curr_value);
 
-      if (functor.key_equals(data_node->key_, key)) {
-        int64_t res = data_node->access_count_.fetch_add(1);
-        if (res >= 0) {  // its not deleted.
-          va.init(&(data_node->value_), &(data_node->access_count_));
-          op_res = true;
-        } else {
-          data_node->access_count_.fetch_add(-1);
-          op_res = false;
-        }
+      if (key_matches(&functor, data_node, digest, key)) {
+        op_res = acquire_value(data_node, va);
       }
       hp_unwatch();
       break;
@@ -510,35 +1090,42 @@ at(Key key, ValueAccessor &va) {
     assert(false);
   }  // while true
 
+  hp_unwatch(SlotID::SHORTUSE2);
   assert(hp_check_empty() && " Error: Function Did not release hp watch ");
   return op_res;
 }  // at
 
 
-template<class Key, class Value, class Functor>
-bool HashMap<Key, Value, Functor>::
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+bool HashMap<Key, Value, Functor, ReclaimPolicy>::
 insert(Key key, Value value) {
   assert(hp_check_empty() && " Error: Function Did not release hp watch ");
-  tervel::util::ProgressAssurance::check_for_announcement();
+  if (kReclaims) {
+    tervel::util::ProgressAssurance::check_for_announcement();
+  }
 
   Functor functor;
-  key = functor.hash(key);
+  Digest digest = functor.hash(key);
 
-  DataNode * new_node = new DataNode(key, value);
+  // Allocated once a position to place it in is found, and reused if the
+  // CAS on that position fails.
+  DataNode * new_node = nullptr;
 
   tervel::util::ProgressAssurance::Limit progAssur;
 
   size_t depth = 0;
-  uint64_t position = get_position(key, depth);
+  uint64_t position = get_position(digest, depth);
   Location *loc = &(primary_array_[position]);
+  ArrayNode *parent = nullptr;
   Node *curr_value;
 
   bool op_res;
   while (true) {
-    if (progAssur.isDelayed(0)) {
-      ForceExpandOp *op = new ForceExpandOp(this, loc, depth);
+    if (kReclaims && progAssur.isDelayed(0)) {
+      ForceExpandOp *op = new ForceExpandOp(this, parent, loc, depth);
       util::ProgressAssurance::make_announcement(
             reinterpret_cast<tervel::util::OpRecord *>(op));
+      op->safe_delete();
       progAssur.reset();
       continue;
     }
@@ -548,9 +1135,17 @@ insert(Key key, Value value) {
       continue;
     }
 
-    if (curr_value == nullptr) {
+    if (is_frozen(curr_value)) {
+      // The parent is being collapsed, help it then retry from the top.
+      restart_traversal(digest, depth, loc, parent);
+      progAssur.isDelayed(1);
+      continue;
+    } else if (curr_value == nullptr) {
+      if (new_node == nullptr) {
+        new_node = new DataNode(digest, key, value);
+      }
       if (loc->compare_exchange_strong(curr_value, new_node)) {
-        size_.fetch_add(1);
+        size_.add(1);
         op_res = true;
         break;
       } else {
@@ -560,19 +1155,22 @@ insert(Key key, Value value) {
     } else if (curr_value->is_array()) {
       ArrayNode * array_node = reinterpret_cast<ArrayNode *>(curr_value);
       depth++;
-      position = get_position(key, depth);
+      position = get_position(digest, depth);
       loc = array_node->access(position);
-      hp_unwatch();
+      hp_descend(parent, array_node);
       continue;
     } else {  // it is a data node
       assert(curr_value->is_data());
       DataNode * data_node = reinterpret_cast<DataNode *>(curr_value);
 
-      if (data_node->access_count_.load() < 0) {
+      if (data_node->is_deleted()) {
+        if (new_node == nullptr) {
+          new_node = new DataNode(digest, key, value);
+        }
         if (loc->compare_exchange_strong(curr_value, new_node)) {
           hp_unwatch();
           data_node->safe_delete();
-          size_.fetch_add(1);
+          size_.add(1);
           op_res = true;
           break;
         } else {
@@ -580,7 +1178,8 @@ insert(Key key, Value value) {
           progAssur.isDelayed(1);
           continue;
         }
-      } else if (functor.key_equals(data_node->key_, key)) {
+      } else if (key_matches(&functor, data_node, digest, key) ||
+          digest_collides(data_node, digest)) {
         op_res = false;
         hp_unwatch();
         break;
@@ -594,31 +1193,35 @@ insert(Key key, Value value) {
     assert(false);
   }  // while true
 
-  if (!op_res) {
+  if (!op_res && new_node != nullptr) {
     assert(loc->load() != new_node);
     delete new_node;
   }
+  hp_unwatch(SlotID::SHORTUSE2);
 
   assert(hp_check_empty() && " Error: Function Did not release hp watch ");
   return op_res;
 }  // insert
 
 
-template<class Key, class Value, class Functor>
-bool HashMap<Key, Value, Functor>::
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+bool HashMap<Key, Value, Functor, ReclaimPolicy>::
 remove(Key key) {
+  static_assert(kReclaims, "remove requires a reclaiming ReclaimPolicy");
   assert(hp_check_empty() && " Error: Function Did not release hp watch ");
   Functor functor;
-  key = functor.hash(key);
+  Digest digest = functor.hash(key);
 
   size_t depth = 0;
-  uint64_t position = get_position(key, depth);
+  uint64_t position = get_position(digest, depth);
 
   Location *loc = &(primary_array_[position]);
+  ArrayNode *parent = nullptr;
 
   tervel::util::ProgressAssurance::Limit progAssur;
 
   bool op_res = false;
+  bool try_compact = false;
   while (true) {
     if (progAssur.isDelayed(0)) {
       //TODO add operation record.
@@ -631,32 +1234,38 @@ remove(Key key) {
       progAssur.isDelayed(1);
       continue;
     }
-    if (curr_value == nullptr) {
+    if (is_frozen(curr_value)) {
+      // The parent is being collapsed, help it then retry from the top.
+      restart_traversal(digest, depth, loc, parent);
+      progAssur.isDelayed(1);
+      continue;
+    } else if (curr_value == nullptr) {
       op_res = false;
       break;
     } else if (curr_value->is_array()) {
       ArrayNode * array_node = reinterpret_cast<ArrayNode *>(curr_value);
       depth++;
-      position = get_position(key, depth);
+      position = get_position(digest, depth);
       loc = array_node->access(position);
-      hp_unwatch();
+      hp_descend(parent, array_node);
       continue;
     } else {  // it is a data node
       assert(curr_value->is_data());
       DataNode *data_node = reinterpret_cast<DataNode *>(curr_value);
       int64_t temp_expected = 0;
-      if (functor.key_equals(data_node->key_, key) &&
+      if (key_matches(&functor, data_node, digest, key) &&
           data_node->access_count_.compare_exchange_strong(temp_expected,
                   -1*tl_thread_info->get_num_threads())
                                                       ) {
         op_res = true;
-        size_.fetch_add(-1);
+        size_.add(-1);
         // data_node is a key match, value match, and we set it to dead
         if (loc->compare_exchange_strong(curr_value, nullptr)) {
             assert(loc->load() != data_node);
             assert(data_node->access_count_.load() < 0);
             hp_unwatch();
             data_node->safe_delete();
+            try_compact = compact_on_remove_ && parent != nullptr;
             break;
         } else {
           // It is logically deleted, and some other thread will/has already removed and freed it
@@ -670,13 +1279,585 @@ remove(Key key) {
     assert(false);
   }  // while
 
+  if (try_compact) {
+    // Cheap check before paying for a collapse, which re-traverses the map.
+    size_t in_use = 0;
+    for (size_t i = 0; i < parent->len() && in_use < 2; i++) {
+      if (parent->access(i)->load() != nullptr) {
+        in_use++;
+      }
+    }
+    hp_unwatch(SlotID::SHORTUSE2);
+    if (in_use < 2) {
+      compact_path(digest, depth);
+    }
+  } else {
+    hp_unwatch(SlotID::SHORTUSE2);
+  }
+
   assert(hp_check_empty() && " Error: Function Did not release hp watch ");
   return op_res;
 }  // remove
 
 
-template<class Key, class Value, class Functor>
-void  HashMap<Key, Value, Functor>::
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+template<class Iterator>
+uint64_t HashMap<Key, Value, Functor, ReclaimPolicy>::
+bulk_load(Iterator begin, Iterator end, size_t num_threads) {
+  const size_t count = end - begin;
+  if (num_threads == 0) {
+    num_threads = 1;
+  }
+
+  // Phase 1: hash the keys and find their primary position.
+  std::vector<Digest> digests(count);
+  std::vector<uint64_t> positions(count);
+  run_in_parallel(num_threads, [&](size_t t) {
+    Functor functor;
+    const size_t first = count * t / num_threads;
+    const size_t last = count * (t + 1) / num_threads;
+    for (size_t i = first; i < last; i++) {
+      Key key = begin[i].first;
+      digests[i] = functor.hash(key);
+      positions[i] = get_position(digests[i], 0);
+    }
+  });
+
+  // Phase 2: group the pairs by primary position, preserving input order.
+  std::vector<size_t> offsets(primary_array_size_ + 1, 0);
+  for (size_t i = 0; i < count; i++) {
+    offsets[positions[i] + 1]++;
+  }
+  for (size_t i = 0; i < primary_array_size_; i++) {
+    offsets[i + 1] += offsets[i];
+  }
+  std::vector<size_t> grouped(count);
+  {
+    std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < count; i++) {
+      grouped[next[positions[i]]++] = i;
+    }
+  }
+  positions.clear();
+
+  // Phase 3: each thread builds the subtrees of a range of positions, split
+  // so that each range holds about the same number of pairs. Data nodes are
+  // created as they are placed, so they are built while in cache and
+  // duplicate keys are never allocated.
+  std::unique_ptr<Location[]> roots(new Location[primary_array_size_]());
+  std::vector<uint64_t> inserted(num_threads, 0);
+  run_in_parallel(num_threads, [&](size_t t) {
+    Functor functor;
+    const size_t first = std::lower_bound(offsets.begin(), offsets.end() - 1,
+          count * t / num_threads) - offsets.begin();
+    const size_t last = (t + 1 == num_threads) ? primary_array_size_ :
+        std::lower_bound(offsets.begin(), offsets.end() - 1,
+          count * (t + 1) / num_threads) - offsets.begin();
+    for (size_t pos = first; pos < last; pos++) {
+      if (offsets[pos] == offsets[pos + 1]) {
+        continue;
+      }
+      Location *root = &(roots[pos]);
+      root->store(primary_array_[pos].load(), std::memory_order_relaxed);
+      for (size_t i = offsets[pos]; i < offsets[pos + 1]; i++) {
+        const size_t idx = grouped[i];
+        Key key = begin[idx].first;
+        Value value = begin[idx].second;
+        if (bulk_place(root, digests[idx], key, value, &functor)) {
+          inserted[t]++;
+        }
+      }
+    }
+  });
+
+  // Phase 4: publish.
+  uint64_t total = 0;
+  for (size_t pos = 0; pos < primary_array_size_; pos++) {
+    if (offsets[pos] != offsets[pos + 1]) {
+      primary_array_[pos].store(roots[pos].load(std::memory_order_relaxed));
+    }
+  }
+  for (uint64_t temp : inserted) {
+    total += temp;
+  }
+  size_.fetch_add(total);
+  return total;
+}  // bulk_load
+
+
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+bool HashMap<Key, Value, Functor, ReclaimPolicy>::
+bulk_place(Location *loc, Digest &digest, Key &key, Value &value,
+      Functor *functor) {
+  size_t depth = 0;
+  while (true) {
+    Node *curr_value = loc->load(std::memory_order_relaxed);
+    if (curr_value == nullptr) {
+      loc->store(new DataNode(digest, key, value), std::memory_order_relaxed);
+      return true;
+    } else if (curr_value->is_array()) {
+      ArrayNode *array_node = reinterpret_cast<ArrayNode *>(curr_value);
+      depth++;
+      loc = array_node->access(get_position(digest, depth));
+      continue;
+    }
+
+    DataNode *curr_data = reinterpret_cast<DataNode *>(curr_value);
+    if (curr_data->is_deleted(std::memory_order_relaxed)) {
+      // Left behind by an earlier remove, no other thread can reference it.
+      loc->store(new DataNode(digest, key, value), std::memory_order_relaxed);
+      delete curr_data;
+      return true;
+    } else if (key_matches(functor, curr_data, digest, key) ||
+        digest_collides(curr_data, digest)) {
+      return false;
+    }
+
+    ArrayNode *array_node = new ArrayNode(secondary_array_size_);
+    array_node->access(get_position(curr_data->key_, depth + 1))->store(
+          curr_data, std::memory_order_relaxed);
+    loc->store(array_node, std::memory_order_relaxed);
+  }
+}  // bulk_place
+
+
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+void HashMap<Key, Value, Functor, ReclaimPolicy>::
+compact() {
+  static_assert(kReclaims, "compact requires a reclaiming ReclaimPolicy");
+  std::vector<uint64_t> path;
+  for (uint64_t i = 0; i < primary_array_size_; i++) {
+    path.push_back(i);
+    compact_subtree(&path);
+    path.pop_back();
+  }
+}  // compact
+
+
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+void HashMap<Key, Value, Functor, ReclaimPolicy>::
+compact_subtree(std::vector<uint64_t> *path) {
+  Location *loc;
+  Node *value;
+  if (!watch_path(path->data(), path->size(), loc, value)) {
+    return;
+  } else if (value == nullptr || value->is_data()) {
+    unwatch_path();
+    return;
+  }
+
+  // Children are collapsed first, as an array node referencing an array node
+  // can not be collapsed.
+  ArrayNode *array_node = reinterpret_cast<ArrayNode *>(value);
+  std::vector<uint64_t> children;
+  for (uint64_t i = 0; i < array_node->len(); i++) {
+    Node *child;
+    while (!hp_watch_and_get_value(array_node->access(i), child)) {}
+    if (child != nullptr && !is_frozen(child) && child->is_array()) {
+      children.push_back(i);
+    }
+    hp_unwatch();
+  }
+  unwatch_path();
+
+  for (uint64_t child : children) {
+    path->push_back(child);
+    compact_subtree(path);
+    path->pop_back();
+  }
+
+  if (watch_path(path->data(), path->size(), loc, value)) {
+    if (value != nullptr && value->is_array()) {
+      array_node = reinterpret_cast<ArrayNode *>(value);
+      if (is_collapsible(array_node)) {
+        collapse(loc, array_node);
+      }
+    }
+    unwatch_path();
+  }
+}  // compact_subtree
+
+
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+void HashMap<Key, Value, Functor, ReclaimPolicy>::
+compact_path(Digest &key, size_t depth) {
+  std::vector<uint64_t> path = key_path(key);
+  for (; depth > 0; depth--) {
+    Location *loc;
+    Node *value;
+    if (!watch_path(path.data(), depth, loc, value)) {
+      continue;
+    }
+    bool collapsed = false;
+    if (value != nullptr && value->is_array()) {
+      ArrayNode *array_node = reinterpret_cast<ArrayNode *>(value);
+      collapsed = is_collapsible(array_node) && collapse(loc, array_node);
+    }
+    unwatch_path();
+    if (!collapsed) {
+      break;
+    }
+  }
+}  // compact_path
+
+
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+void HashMap<Key, Value, Functor, ReclaimPolicy>::
+help_collapse(Digest &key) {
+  std::vector<uint64_t> path = key_path(key);
+  Location *loc;
+  Node *value;
+  // watch_path completes each collapse it encounters on the way down.
+  if (watch_path(path.data(), path.size(), loc, value)) {
+    unwatch_path();
+  }
+}  // help_collapse
+
+
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+void HashMap<Key, Value, Functor, ReclaimPolicy>::
+restart_traversal(Digest &key, size_t &depth, Location * &loc,
+      ArrayNode * &parent) {
+  hp_unwatch(SlotID::SHORTUSE2);
+  help_collapse(key);
+  depth = 0;
+  loc = &(primary_array_[get_position(key, depth)]);
+  parent = nullptr;
+}  // restart_traversal
+
+
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+std::vector<uint64_t> HashMap<Key, Value, Functor, ReclaimPolicy>::
+key_path(Digest &key) {
+  // Stop once the key's bits are exhausted, deeper positions are undefined.
+  const size_t key_bits = sizeof(Digest) * 8;
+  std::vector<uint64_t> path;
+  path.push_back(get_position(key, 0));
+  for (size_t i = 1; i <= max_depth() &&
+      (i - 1) * secondary_array_pow_ + primary_array_pow_ < key_bits; i++) {
+    path.push_back(get_position(key, i));
+  }
+  return path;
+}  // key_path
+
+
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+bool HashMap<Key, Value, Functor, ReclaimPolicy>::
+watch_path(const uint64_t *path, size_t length, Location * &loc,
+      Node * &value) {
+  assert(length > 0);
+  assert(hp_check_empty(SlotID::SHORTUSE2));
+  assert(hp_check_empty(SlotID::SHORTUSE3));
+
+  while (true) {
+    loc = &(primary_array_[path[0]]);
+    // Positions of the primary array are never frozen.
+    while (!hp_watch_and_get_value(loc, value, SlotID::SHORTUSE2)) {}
+
+    bool restart = false;
+    for (size_t depth = 1; depth < length; depth++) {
+      if (value == nullptr || value->is_data()) {
+        unwatch_path();
+        return false;
+      }
+
+      ArrayNode *array_node = reinterpret_cast<ArrayNode *>(value);
+      Location *next_loc = array_node->access(path[depth]);
+      Node *next_value;
+      while (!hp_watch_and_get_value(next_loc, next_value)) {}
+
+      if (is_frozen(next_value)) {
+        collapse(loc, array_node);
+        unwatch_path();
+        restart = true;
+        break;
+      }
+
+      // Shift the watches down a level, each node remains protected by the
+      // slot it is in while it is written to the next.
+      hp_unwatch(SlotID::SHORTUSE3);
+      hp_watch(SlotID::SHORTUSE3, array_node);
+      hp_unwatch(SlotID::SHORTUSE2);
+      if (next_value != nullptr) {
+        hp_watch(SlotID::SHORTUSE2, next_value);
+      }
+      hp_unwatch();
+
+      loc = next_loc;
+      value = next_value;
+    }
+
+    if (!restart) {
+      return true;
+    }
+  }
+}  // watch_path
+
+
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+void HashMap<Key, Value, Functor, ReclaimPolicy>::
+unwatch_path() {
+  hp_unwatch(SlotID::SHORTUSE2);
+  hp_unwatch(SlotID::SHORTUSE3);
+}  // unwatch_path
+
+
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+bool HashMap<Key, Value, Functor, ReclaimPolicy>::
+is_collapsible(ArrayNode *array_node) {
+  size_t live = 0;
+  for (uint64_t i = 0; i < array_node->len(); i++) {
+    Node *child;
+    while (!hp_watch_and_get_value(array_node->access(i), child)) {}
+
+    if (is_frozen(child)) {
+      // Already being collapsed.
+      return true;
+    } else if (child == nullptr) {
+      continue;
+    } else if (child->is_array()) {
+      live = 2;
+    } else if (!reinterpret_cast<DataNode *>(child)->is_deleted()) {
+      live++;
+    }
+    hp_unwatch();
+
+    if (live > 1) {
+      return false;
+    }
+  }
+  return true;
+}  // is_collapsible
+
+
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+bool HashMap<Key, Value, Functor, ReclaimPolicy>::
+collapse(Location *loc, ArrayNode *array_node) {
+  const uint64_t len = array_node->len();
+
+  // Freeze each position, after which no thread can add or remove a reference.
+  for (uint64_t i = 0; i < len; i++) {
+    Location *pos = array_node->access(i);
+    Node *temp = pos->load();
+    while (!is_frozen(temp) && !pos->compare_exchange_weak(temp,
+          tervel::util::set_1st_lsb_1(temp))) {}
+  }
+
+  std::vector<Node *> kept(len, nullptr);
+  std::vector<DataNode *> dropped;
+  Node *last_live = nullptr;
+  size_t live = 0;
+  size_t arrays = 0;
+
+  for (uint64_t i = 0; i < len; i++) {
+    Node *child = tervel::util::set_1st_lsb_0(array_node->access(i)->load());
+    if (child == nullptr) {
+      continue;
+    }
+
+    // While array_node is still at loc, no thread has retired its children.
+    hp_watch(SlotID::SHORTUSE, child);
+    if (loc->load() != array_node) {
+      hp_unwatch();
+      return false;
+    }
+
+    if (child->is_array()) {
+      arrays++;
+      kept[i] = child;
+    } else if (reinterpret_cast<DataNode *>(child)->is_deleted()) {
+      dropped.push_back(reinterpret_cast<DataNode *>(child));
+    } else {
+      live++;
+      last_live = child;
+      kept[i] = child;
+    }
+    hp_unwatch();
+  }
+
+  Node *replacement;
+  ArrayNode *copy = nullptr;
+  if (arrays == 0 && live <= 1) {
+    replacement = last_live;
+  } else {
+    // An entry was added before its position was frozen.
+    copy = new ArrayNode(len);
+    for (uint64_t i = 0; i < len; i++) {
+      copy->access(i)->store(kept[i]);
+    }
+    replacement = copy;
+  }
+
+  Node *expected = array_node;
+  if (loc->compare_exchange_strong(expected, replacement)) {
+    for (DataNode *data_node : dropped) {
+      data_node->safe_delete();
+    }
+    array_node->safe_delete();
+    return true;
+  } else {
+    if (copy != nullptr) {
+      for (uint64_t i = 0; i < len; i++) {
+        copy->access(i)->store(nullptr);
+      }
+      delete copy;
+    }
+    return false;
+  }
+}  // collapse
+
+
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+typename HashMap<Key, Value, Functor, ReclaimPolicy>::Statistics
+HashMap<Key, Value, Functor, ReclaimPolicy>::
+statistics() {
+  StatisticsVisitor visitor;
+  walk(&visitor);
+  return visitor.stats_;
+}  // statistics
+
+
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+bool HashMap<Key, Value, Functor, ReclaimPolicy>::
+save_snapshot(const std::string &path) {
+  static_assert(!kStoresKey,
+        "Snapshots require keys which are their own digest");
+  SnapshotWriter<Digest, Value> writer;
+  if (!writer.open(path)) {
+    return false;
+  }
+  SnapshotVisitor visitor(&writer);
+  walk(&visitor);
+  return writer.close();
+}  // save_snapshot
+
+
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+bool HashMap<Key, Value, Functor, ReclaimPolicy>::
+load_snapshot(const std::string &path, size_t num_threads) {
+  static_assert(!kStoresKey,
+        "Snapshots require keys which are their own digest");
+  SnapshotReader<Digest, Value> reader;
+  if (!reader.open(path)) {
+    return false;
+  }
+  if (num_threads == 0) {
+    num_threads = 1;
+  }
+
+  // Records are ordered by hashed key, so each range holds whole primary
+  // positions and each position's records are contiguous.
+  std::vector<uint64_t> bounds = reader.partition(num_threads,
+        [this](Digest &digest) { return get_position(digest, 0); });
+  std::unique_ptr<Location[]> roots(new Location[primary_array_size_]());
+  std::vector<uint8_t> used(primary_array_size_, 0);
+  std::vector<uint64_t> inserted(bounds.size() - 1, 0);
+
+  run_in_parallel(bounds.size() - 1, [&](size_t t) {
+    Functor functor;
+    uint64_t pos = primary_array_size_;
+    Location *root = nullptr;
+    for (uint64_t i = bounds[t]; i < bounds[t + 1]; i++) {
+      Digest digest;
+      Value value;
+      reader.record(i, &digest, &value);
+      const uint64_t temp = get_position(digest, 0);
+      if (temp != pos) {
+        pos = temp;
+        root = &(roots[pos]);
+        root->store(primary_array_[pos].load(), std::memory_order_relaxed);
+        used[pos] = 1;
+      }
+      if (bulk_place(root, digest, digest, value, &functor)) {
+        inserted[t]++;
+      }
+    }
+  });
+
+  uint64_t total = 0;
+  for (size_t pos = 0; pos < primary_array_size_; pos++) {
+    if (used[pos]) {
+      primary_array_[pos].store(roots[pos].load(std::memory_order_relaxed));
+    }
+  }
+  for (uint64_t temp : inserted) {
+    total += temp;
+  }
+  size_.fetch_add(total);
+  return true;
+}  // load_snapshot
+
+
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+template<class Visitor>
+void HashMap<Key, Value, Functor, ReclaimPolicy>::
+walk(Visitor *visitor) {
+  std::vector<uint64_t> path;
+  for (uint64_t i = 0; i < primary_array_size_; i++) {
+    path.push_back(i);
+    walk_subtree(&path, visitor);
+    path.pop_back();
+  }
+}  // walk
+
+
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+template<class Visitor>
+void HashMap<Key, Value, Functor, ReclaimPolicy>::
+walk_subtree(std::vector<uint64_t> *path, Visitor *visitor) {
+  const uint64_t depth = path->size() - 1;
+  Location *loc;
+  Node *value;
+  if (!watch_path(path->data(), path->size(), loc, value)) {
+    return;
+  } else if (value == nullptr) {
+    unwatch_path();
+    return;
+  } else if (value->is_data()) {
+    visitor->visit_data(reinterpret_cast<DataNode *>(value), depth);
+    unwatch_path();
+    return;
+  }
+
+  ArrayNode *array_node = reinterpret_cast<ArrayNode *>(value);
+  std::vector<uint64_t> children;
+  for (uint64_t i = 0; i < array_node->len(); i++) {
+    Node *child;
+    while (!hp_watch_and_get_value(array_node->access(i), child)) {}
+    if (child != nullptr) {
+      children.push_back(i);
+    }
+    hp_unwatch();
+  }
+  visitor->visit_array(array_node, array_node->len() - children.size());
+  unwatch_path();
+
+  for (uint64_t child : children) {
+    path->push_back(child);
+    walk_subtree(path, visitor);
+    path->pop_back();
+  }
+}  // walk_subtree
+
+
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+void HashMap<Key, Value, Functor, ReclaimPolicy>::
+free_node(Node *node) {
+  node = tervel::util::set_1st_lsb_0(node);
+  if (node == nullptr) {
+    return;
+  } else if (node->is_array()) {
+    ArrayNode *array_node = reinterpret_cast<ArrayNode *>(node);
+    for (uint64_t i = 0; i < array_node->len(); i++) {
+      free_node(array_node->access(i)->exchange(nullptr));
+    }
+  }
+  delete node;
+}  // free_node
+
+
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+void  HashMap<Key, Value, Functor, ReclaimPolicy>::
 expand_map(Location * loc, Node * curr_value, size_t depth) {
 
   uint64_t next_position = 0;
@@ -699,11 +1880,11 @@ expand_map(Location * loc, Node * curr_value, size_t depth) {
   }
 }  // expand
 
-template<class Key, class Value, class Functor>
-uint64_t HashMap<Key, Value, Functor>::
-get_position(Key &key, size_t depth) {
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+uint64_t HashMap<Key, Value, Functor, ReclaimPolicy>::
+get_position(Digest &key, size_t depth) {
   const uint64_t *long_array = reinterpret_cast<uint64_t *>(&key);
-  const size_t max_length = sizeof(Key) / (64 / 8);
+  const size_t max_length = sizeof(Digest) / (64 / 8);
 
   assert(depth <= max_depth());
   if (depth == 0) {
@@ -730,7 +1911,8 @@ get_position(Key &key, size_t depth) {
 
     // TODO(steven): add 0 padding to fill extra bits if the bits don't
     // divide evenly.
-    if (start_idx == end_idx) {
+    // A position ending on a word boundary lies entirely in start_idx.
+    if (start_idx == end_idx || end_idx_offset == 0) {
       uint64_t value = long_array[start_idx];
       value = value << start_idx_offset;
       value = value >> (64 - secondary_array_pow_);
@@ -759,10 +1941,10 @@ get_position(Key &key, size_t depth) {
   }
 }  // get_position
 
-template<class Key, class Value, class Functor>
-uint64_t HashMap<Key, Value, Functor>::
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+uint64_t HashMap<Key, Value, Functor, ReclaimPolicy>::
 max_depth() {
-  uint64_t max_depth = sizeof(Key)*8;
+  uint64_t max_depth = sizeof(Digest)*8;
   max_depth -= primary_array_pow_;
   max_depth = std::ceil(max_depth / secondary_array_pow_);
   max_depth++;
@@ -770,13 +1952,13 @@ max_depth() {
   return max_depth;
 }
 
-template<class Key, class Value, class Functor>
-void HashMap<Key, Value, Functor>::
+template<class Key, class Value, class Functor, class ReclaimPolicy>
+void HashMap<Key, Value, Functor, ReclaimPolicy>::
 print_key(Key &key) {
-  size_t max_depth_ = max_depth();
+  Functor functor;
+  Digest digest = functor.hash(key);
   std::cout << "K(" << key << ") :";
-  for (size_t i = 0; i <= max_depth_; i++) {
-    uint64_t temp = get_position(key, i);
+  for (uint64_t temp : key_path(digest)) {
     std::cout << temp << "-";
   }
   std::cout << "\n" << std::endl;
@@ -0,0 +1,134 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef TERVEL_CONTAINERS_WF_LINKED_LIST_QUEUE_ACCESSOR_H_
+#define TERVEL_CONTAINERS_WF_LINKED_LIST_QUEUE_ACCESSOR_H_
+
+#include <tervel/util/util.h>
+#include <tervel/util/memory/hp/hazard_pointer.h>
+#include <tervel/containers/wf/linked_list_queue/queue.h>
+
+namespace tervel {
+namespace containers {
+namespace wf {
+
+/**
+  * This defines the Accessor class, it holds the hazard pointer watches an
+  * operation needs on a node and its successor, and the value of a dequeue.
+  *
+  * If it reads a marked Helper instead of a node, it completes the Helper
+  * and reports failure so the caller reloads. The watches are removed by
+  * unaccess and when the accessor is destroyed.
+  */
+template<typename T>
+class Queue<T>::Accessor {
+ public:
+  typedef tervel::util::memory::hp::HazardPointer::SlotID SlotID;
+  // SHORTUSE2 is used by Helper::on_watch to watch its op.
+  static const SlotID node_pos = SlotID::SHORTUSE;
+  static const SlotID next_pos = SlotID::SHORTUSE3;
+
+  Accessor() {};
+  ~Accessor() {
+    unaccess();
+  };
+
+/**
+  * Watches the node stored at address.
+  *
+  * @param address Address of the std::atomic<Node *> to be loaded.
+  * @return true if the node was watched while still stored at address.
+  */
+  bool load(std::atomic<Node *> *address) {
+    Node *element = address->load();
+    if (!watch(node_pos, address, element)) {
+      return false;
+    }
+    node_ = element;
+    return true;
+  };
+
+/**
+  * Watches the successor of the loaded node, it is only protected once the
+  * caller has checked that the loaded node is still the head or tail.
+  *
+  * @return true if the successor, which may be nullptr, is in next_ptr().
+  */
+  bool load_next() {
+    std::atomic<Node *> *address = node_->next_address();
+    Node *element = address->load();
+    if (element != nullptr && !watch(next_pos, address, element)) {
+      return false;
+    }
+    next_ = element;
+    return true;
+  };
+
+/**
+  * Removes the watches placed by load and load_next.
+  */
+  void unaccess() {
+    tervel::util::memory::hp::HazardPointer::unwatch(node_pos);
+    tervel::util::memory::hp::HazardPointer::unwatch(next_pos);
+    node_ = nullptr;
+    next_ = nullptr;
+  };
+
+/**
+  * @return the value of the last successful dequeue using this accessor.
+  */
+  T value() { return val_; };
+
+  Node * ptr() { return node_; };
+  Node * next_ptr() { return next_; };
+
+ private:
+  bool watch(SlotID pos, std::atomic<Node *> *address, Node *element) {
+    std::atomic<void *> *temp_address =
+        reinterpret_cast<std::atomic<void *> *>(address);
+    if (tervel::util::is_1st_lsb_1<Node>(element)) {
+      Helper *h = reinterpret_cast<Helper *>(
+          tervel::util::set_1st_lsb_0<Node>(element));
+      // Helper::on_watch completes the helper and always fails.
+      bool res = tervel::util::memory::hp::HazardPointer::watch(pos, h,
+          temp_address, element);
+      assert(res == false);
+      (void)res;
+      return false;
+    }
+    return tervel::util::memory::hp::HazardPointer::watch(pos,
+        reinterpret_cast<void *>(element), temp_address, element);
+  };
+
+  Node *node_ {nullptr};
+  Node *next_ {nullptr};
+  T val_ {};
+  friend class Queue<T>;
+};
+
+}  // namespace wf
+}  // namespace containers
+}  // namespace tervel
+
+#endif  // TERVEL_CONTAINERS_WF_LINKED_LIST_QUEUE_ACCESSOR_H_
@@ -0,0 +1,77 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef TERVEL_CONTAINERS_WF_LINKED_LIST_QUEUE_NODE_H_
+#define TERVEL_CONTAINERS_WF_LINKED_LIST_QUEUE_NODE_H_
+
+#include <tervel/util/info.h>
+#include <tervel/util/memory/node_pool.h>
+#include <tervel/util/memory/hp/hp_element.h>
+
+#include <tervel/containers/wf/linked_list_queue/queue.h>
+
+namespace tervel {
+namespace containers {
+namespace wf {
+
+/**
+  * This defines the Node class. This class extends the "Element" class,
+  * enabling the use of hazard pointers with Node objects. Nodes are allocated
+  * from the thread's NodePool.
+  *
+  * The next of the last node may hold a marked Helper while an EnqueueOp is
+  * being completed, it is otherwise written once.
+  */
+template<typename T>
+class Queue<T>::Node : public tervel::util::memory::hp::Element {
+ public:
+  Node() {};
+  explicit Node(const T &v) : val_(v) {};
+  ~Node() {};
+
+  static void * operator new(size_t size) {
+    return tervel::util::memory::NodePool::allocate(size);
+  }
+
+  static void operator delete(void *ptr, size_t size) {
+    tervel::util::memory::NodePool::release(ptr, size);
+  }
+
+  T value() { return val_; };
+  Node *next() { return next_.load(); };
+  std::atomic<Node *> *next_address() { return &next_; };
+  bool cas_next(Node *expected, Node *n) {
+    return next_.compare_exchange_strong(expected, n);
+  };
+
+ private:
+  T val_ {};
+  std::atomic<Node *> next_ {nullptr};
+};
+
+}  // namespace wf
+}  // namespace containers
+}  // namespace tervel
+
+#endif  // TERVEL_CONTAINERS_WF_LINKED_LIST_QUEUE_NODE_H_
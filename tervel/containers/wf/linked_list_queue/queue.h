@@ -0,0 +1,127 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef TERVEL_CONTAINERS_WF_LINKED_LIST_QUEUE_QUEUE_H_
+#define TERVEL_CONTAINERS_WF_LINKED_LIST_QUEUE_QUEUE_H_
+
+#include <atomic>
+#include <assert.h>
+#include <stddef.h>
+
+#include <tervel/util/info.h>
+#include <tervel/util/util.h>
+#include <tervel/util/padded_atomic.h>
+#include <tervel/util/sharded_counter.h>
+#include <tervel/util/progress_assurance.h>
+#include <tervel/util/memory/hp/hp_element.h>
+#include <tervel/util/memory/hp/hazard_pointer.h>
+
+namespace tervel {
+namespace containers {
+namespace wf {
+
+/**
+ * @brief An unbounded FIFO queue of linked nodes.
+ *
+ * @details Operations run as in the lock-free queue of Michael and Scott
+ * until they are delayed, then they announce an EnqueueOp or DequeueOp and
+ * every thread helps complete it, in the spirit of Kogan and Petrank's
+ * wait-free queue but using Tervel's progress assurance.
+ *
+ * A helping thread does not write its result directly, as two helpers could
+ * both apply it. Instead it places a marked Helper where the result goes: at
+ * the next of the last node for an enqueue, or at head_ for a dequeue. The
+ * Helper is then associated with the op, and it is replaced by the result if
+ * it was the first Helper associated, or by the old value otherwise. A thread
+ * which reads a marked Helper completes it before continuing, see
+ * Accessor::load.
+ *
+ * Nodes are protected by hazard pointers and freed with safe_delete, their
+ * memory is taken from and returned to the thread's NodePool.
+ *
+ * @tparam T The type of information stored, it is copied in and out.
+ */
+template<typename T>
+class Queue {
+ public:
+  class Node;
+  class Accessor;
+  class Helper;
+  class QueueOp;
+  class EnqueueOp;
+  class DequeueOp;
+
+  Queue();
+  ~Queue();
+
+  /**
+   * @brief Enqueues the value at the end of the queue.
+   *
+   * @param value The value to enqueue.
+   * @return true, the queue is never full.
+   */
+  bool enqueue(T value);
+
+  /**
+   * @brief Dequeues the value at the front of the queue.
+   *
+   * @param access An accessor which receives the dequeued value, see
+   * Accessor::value.
+   * @return whether or not a value was dequeued.
+   */
+  bool dequeue(Accessor &access);
+
+  /**
+   * @return whether or not the queue was empty when checked.
+   */
+  bool empty();
+
+  /**
+   * @return the number of values in the queue.
+   */
+  int64_t size() {
+    return current_size_.load();
+  }
+
+ private:
+  // Each is padded to a cache line, so enqueues, which update tail_, and
+  // dequeues, which update head_, do not contend for one.
+  util::PaddedAtomic<Node *> head_;
+  util::PaddedAtomic<Node *> tail_;
+  util::SizeCounter current_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(Queue);
+};  // class Queue
+
+}  // namespace wf
+}  // namespace containers
+}  // namespace tervel
+
+#include <tervel/containers/wf/linked_list_queue/node.h>
+#include <tervel/containers/wf/linked_list_queue/helper.h>
+#include <tervel/containers/wf/linked_list_queue/accessor.h>
+#include <tervel/containers/wf/linked_list_queue/queue_op.h>
+#include <tervel/containers/wf/linked_list_queue/queue_imp.h>
+
+#endif  // TERVEL_CONTAINERS_WF_LINKED_LIST_QUEUE_QUEUE_H_
@@ -0,0 +1,156 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef TERVEL_CONTAINERS_WF_LINKED_LIST_QUEUE_QUEUE_IMP_H_
+#define TERVEL_CONTAINERS_WF_LINKED_LIST_QUEUE_QUEUE_IMP_H_
+
+#include <tervel/containers/wf/linked_list_queue/queue.h>
+#include <tervel/util/progress_assurance.h>
+
+namespace tervel {
+namespace containers {
+namespace wf {
+
+template<typename T>
+Queue<T>::Queue() {
+  Node *dummy = new Node();
+  head_.store(dummy);
+  tail_.store(dummy);
+}
+
+template<typename T>
+Queue<T>::~Queue() {
+  Node *cur = head_.load();
+  while (cur != nullptr) {
+    Node *next = cur->next();
+    delete cur;
+    cur = next;
+  }
+}
+
+template<typename T>
+bool Queue<T>::enqueue(T value) {
+  Node *elem = new Node(value);
+
+  tervel::util::ProgressAssurance::check_for_announcement();
+  util::ProgressAssurance::Limit progAssur;
+
+  while (!progAssur.isDelayed()) {
+    Accessor access;
+    if (access.load(&tail_.atomic) == false) {
+      continue;
+    }
+    Node *tail = access.ptr();
+    if (access.load_next() == false) {
+      continue;
+    }
+
+    Node *next = access.next_ptr();
+    if (next != nullptr) {
+      // tail_ lags behind, move it forward and retry.
+      tail_.compare_exchange_strong(tail, next);
+    } else if (tail->cas_next(nullptr, elem)) {
+      tail_.compare_exchange_strong(tail, elem);
+      current_size_.add(1);
+      return true;
+    }
+  }  // while (!progAssur.isDelayed())
+
+  EnqueueOp *op = new EnqueueOp(this, elem);
+  tervel::util::ProgressAssurance::make_announcement(op);
+  op->safe_delete();
+  current_size_.add(1);
+  return true;
+}  // bool enqueue(T value)
+
+template<typename T>
+bool Queue<T>::dequeue(Accessor &access) {
+  tervel::util::ProgressAssurance::check_for_announcement();
+  util::ProgressAssurance::Limit progAssur;
+
+  while (!progAssur.isDelayed()) {
+    access.unaccess();
+    if (access.load(&head_.atomic) == false) {
+      continue;
+    }
+    Node *head = access.ptr();
+    if (access.load_next() == false) {
+      continue;
+    }
+
+    // next is protected only if it has not been dequeued since it was
+    // watched, which is the case while head is still the head.
+    Node *next = access.next_ptr();
+    if (head_.load() != head) {
+      continue;
+    }
+
+    if (next == nullptr) {
+      access.unaccess();
+      return false;
+    }
+
+    Node *tail = tail_.load();
+    if (head == tail) {
+      // Do not let the head pass the tail, whose node would be freed.
+      tail_.compare_exchange_strong(tail, next);
+      continue;
+    }
+
+    T value = next->value();
+    if (head_.compare_exchange_strong(head, next)) {
+      access.val_ = value;
+      access.unaccess();
+      head->safe_delete();
+      current_size_.add(-1);
+      return true;
+    }
+  }  // while (!progAssur.isDelayed())
+  access.unaccess();
+
+  DequeueOp *op = new DequeueOp(this);
+  tervel::util::ProgressAssurance::make_announcement(op);
+  bool res = op->result(access.val_);
+  op->safe_delete();
+  if (res) {
+    current_size_.add(-1);
+  }
+  return res;
+}  // bool dequeue(Accessor &access)
+
+template<typename T>
+bool Queue<T>::empty() {
+  while (true) {
+    Accessor access;
+    if (access.load(&head_.atomic) && access.load_next()) {
+      return access.next_ptr() == nullptr;
+    }
+  }
+}
+
+}  // namespace wf
+}  // namespace containers
+}  // namespace tervel
+
+#endif  // TERVEL_CONTAINERS_WF_LINKED_LIST_QUEUE_QUEUE_IMP_H_
@@ -0,0 +1,262 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef TERVEL_CONTAINERS_WF_LINKED_LIST_QUEUE_QUEUE_OP_H_
+#define TERVEL_CONTAINERS_WF_LINKED_LIST_QUEUE_QUEUE_OP_H_
+
+#include <tervel/util/util.h>
+#include <tervel/util/progress_assurance.h>
+#include <tervel/util/memory/hp/hp_element.h>
+#include <tervel/util/memory/hp/hazard_pointer.h>
+
+#include <tervel/containers/wf/linked_list_queue/queue.h>
+#include <tervel/containers/wf/linked_list_queue/helper.h>
+
+namespace tervel {
+namespace containers {
+namespace wf {
+
+/**
+  * This defines the QueueOp class, which extends OpRecord. It is the part of
+  * EnqueueOp and DequeueOp that records which Helper, if any, completed the
+  * operation.
+  */
+template<typename T>
+class Queue<T>::QueueOp : public util::OpRecord {
+ public:
+  explicit QueueOp(Queue<T> *queue) : queue_(queue) { };
+  ~QueueOp() {
+    Helper *h = helper_.load();
+    assert(h != nullptr);
+    if (h != fail_val_) {
+      delete h;
+    }
+  };
+
+  /**
+   * @return whether or not h is the helper associated with the op, it is
+   * associated if no other helper was associated first.
+   */
+  bool associate(Helper *h) {
+    Helper *temp = nullptr;
+    bool res = helper_.compare_exchange_strong(temp, h);
+    // success, possibly by another thread finishing h
+    return res || temp == h;
+  };
+
+  /**
+   * Called once, by the thread which replaced the associated helper by its
+   * new value.
+   */
+  virtual void on_finish(Helper *h) {
+    (void)h;
+  };
+
+  void fail() {
+    Helper *temp = nullptr;
+    helper_.compare_exchange_strong(temp, fail_val_);
+  };
+
+  bool result(T &val) {
+    Helper *helper = helper_.load();
+    if (helper == fail_val_) {
+      return false;
+    } else {
+      val = helper->value_;
+      return true;
+    }
+  }
+
+  bool notValid(Helper * h) {
+    return helper_.load() != h;
+  }
+
+  bool notDone() {
+    return helper_.load() == nullptr;
+  };
+
+  bool on_watch(std::atomic<void *> *address, void *expected) {
+    (void)address;
+    (void)expected;
+    return true;
+  };
+
+  bool on_is_watched() {
+    Helper *h = helper_.load();
+    assert(h != nullptr);
+    if (h != fail_val_) {
+      return tervel::util::memory::hp::HazardPointer::is_watched(h);
+    }
+    return false;
+  }
+
+  static Helper * const fail_val_;
+
+  Queue<T> * const queue_;
+  std::atomic<Helper *> helper_{nullptr};
+  DISALLOW_COPY_AND_ASSIGN(QueueOp);
+};  // class QueueOp
+
+template<typename T>
+typename Queue<T>::Helper * const Queue<T>::QueueOp::fail_val_ =
+    reinterpret_cast<typename Queue<T>::Helper *>(0x1L);
+
+/**
+  * This defines the DequeueOp class. Its helpers are placed at head_, with
+  * the head as their old value and its successor as their new value.
+  */
+template<typename T>
+class Queue<T>::DequeueOp: public QueueOp {
+ public:
+  explicit DequeueOp(Queue<T> *q)
+    : QueueOp(q) {}
+
+  /**
+   * The helper which moved head_ frees the old head, as a dequeue does.
+   */
+  void on_finish(Helper *h) {
+    h->old_value_->safe_delete();
+  }
+
+/**
+  * help_complete must be implemented when extending util::OpRecord.
+  * This method gurantees that upon return, the described dequeue operation
+  * is complete.
+  */
+  void help_complete() {
+    Queue<T> * const queue = QueueOp::queue_;
+    Helper * helper = new Helper(this);
+    Node *helper_marked = reinterpret_cast<Node *>(
+        tervel::util::set_1st_lsb_1<Helper>(helper));
+
+    // The logic is the same as that of Queue::dequeue, except that head_ is
+    // replaced by the helper.
+    while (QueueOp::notDone()) {
+      Accessor access;
+      if (access.load(&(queue->head_.atomic)) == false) {
+        continue;
+      }
+      Node *head = access.ptr();
+      if (access.load_next() == false) {
+        continue;
+      }
+      Node *next = access.next_ptr();
+      if (queue->head_.load() != head) {
+        continue;
+      }
+
+      if (next == nullptr) {
+        QueueOp::fail();
+        break;
+      }
+
+      Node *tail = queue->tail_.load();
+      if (head == tail) {
+        queue->tail_.compare_exchange_strong(tail, next);
+        continue;
+      }
+
+      helper->old_value_ = head;
+      helper->new_value_ = next;
+      helper->value_ = next->value();
+      if (queue->head_.compare_exchange_strong(head, helper_marked)) {
+        helper->finish(&(queue->head_.atomic), helper_marked);
+        assert(queue->head_.load() != helper_marked);
+        if (QueueOp::notValid(helper)) {
+          helper->safe_delete();
+        }
+        return;
+      }
+    }  // while (notDone)
+    delete helper;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(DequeueOp);
+};  // DequeueOp
+
+/**
+  * This defines the EnqueueOp class. Its helpers are placed at the next of
+  * the last node, with nullptr as their old value and elem_ as their new
+  * value.
+  */
+template<typename T>
+class Queue<T>::EnqueueOp: public QueueOp {
+ public:
+  EnqueueOp(Queue<T> *q, Node * elem)
+    : QueueOp(q)
+    , elem_(elem) {}
+
+/**
+  * help_complete must be implemented when extending util::OpRecord.
+  * This method gurantees that upon return, the described enqueue operation
+  * is complete.
+  */
+  void help_complete() {
+    Queue<T> * const queue = QueueOp::queue_;
+    Helper * helper = new Helper(this);
+    helper->new_value_ = elem_;
+    Node *helper_marked = reinterpret_cast<Node *>(
+        tervel::util::set_1st_lsb_1<Helper>(helper));
+
+    while (QueueOp::notDone()) {
+      Accessor access;
+      if (access.load(&(queue->tail_.atomic)) == false) {
+        continue;
+      }
+      Node *tail = access.ptr();
+      if (access.load_next() == false) {
+        continue;
+      }
+      Node *next = access.next_ptr();
+      if (next != nullptr) {
+        queue->tail_.compare_exchange_strong(tail, next);
+        continue;
+      }
+
+      if (tail->cas_next(nullptr, helper_marked)) {
+        helper->finish(tail->next_address(), helper_marked);
+        assert(tail->next() != helper_marked);
+        if (QueueOp::notValid(helper)) {
+          helper->safe_delete();
+        } else {
+          // tail is watched, so while it is the tail elem_ follows it.
+          queue->tail_.compare_exchange_strong(tail, elem_);
+        }
+        return;
+      }
+    }  // while (notDone)
+    delete helper;
+  }
+
+ private:
+  Node * const elem_;
+  DISALLOW_COPY_AND_ASSIGN(EnqueueOp);
+};  // EnqueueOp
+
+}  // namespace wf
+}  // namespace containers
+}  // namespace tervel
+
+#endif  // TERVEL_CONTAINERS_WF_LINKED_LIST_QUEUE_QUEUE_OP_H_
@@ -0,0 +1,78 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef TERVEL_CONTAINERS_WF_RINGBUFFER_BUFFER_ROLE_H_
+#define TERVEL_CONTAINERS_WF_RINGBUFFER_BUFFER_ROLE_H_
+
+namespace tervel {
+namespace containers {
+namespace wf {
+namespace buffer_role {
+
+/**
+ * The roles a RingBuffer can be specialised for. The role is a promise made
+ * by the user: a buffer declared with a single producer (or consumer) must
+ * only ever be enqueued to (or dequeued from) by one thread at a time.
+ */
+
+/**
+ * Any number of producers and consumers, the default.
+ */
+struct MPMC {
+  static const bool kMultiProducer = true;
+  static const bool kMultiConsumer = true;
+};
+
+/**
+ * Any number of producers and a single consumer. The consumer owns the head
+ * counter and does not make announcements.
+ */
+struct MPSC {
+  static const bool kMultiProducer = true;
+  static const bool kMultiConsumer = false;
+};
+
+/**
+ * A single producer and any number of consumers. The producer owns the tail
+ * counter and does not make announcements.
+ */
+struct SPMC {
+  static const bool kMultiProducer = false;
+  static const bool kMultiConsumer = true;
+};
+
+/**
+ * A single producer and a single consumer, see spsc_ring_buffer.h.
+ */
+struct SPSC {
+  static const bool kMultiProducer = false;
+  static const bool kMultiConsumer = false;
+};
+
+}  // namespace buffer_role
+}  // namespace wf
+}  // namespace containers
+}  // namespace tervel
+
+#endif  // TERVEL_CONTAINERS_WF_RINGBUFFER_BUFFER_ROLE_H_
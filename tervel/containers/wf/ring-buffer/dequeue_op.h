@@ -31,10 +31,10 @@ namespace tervel {
 namespace containers {
 namespace wf {
 
-template<typename T>
-class RingBuffer<T>::DequeueOp: public BufferOp {
+template<typename T, class Role>
+class RingBuffer<T, Role>::DequeueOp: public BufferOp {
  public:
-  DequeueOp(RingBuffer<T> *rb)
+  DequeueOp(RingBuffer<T, Role> *rb)
     : BufferOp(rb) {}
 
   void * associate(Helper *h);
@@ -32,9 +32,9 @@ namespace tervel {
 namespace containers {
 namespace wf {
 
-template<typename T>
+template<typename T, class Role>
 void
-RingBuffer<T>::DequeueOp::
+RingBuffer<T, Role>::DequeueOp::
 help_complete() {
   int64_t head = this->rb_->getHead();
   while(this->BufferOp::notDone()) {
@@ -57,7 +57,7 @@ help_complete() {
       int64_t val_seqid;
       bool val_isValueType;
       bool val_isDelayedMarked;
-      this->rb_->getInfo(val, val_seqid, val_isValueType, val_isDelayedMarked);
+      this->rb_->getInfo(val, seqid, val_seqid, val_isValueType, val_isDelayedMarked);
 
 
       if (val_seqid > head) {
@@ -68,7 +68,7 @@ help_complete() {
         // so we take it or try to any way...
         // NOTE(steven): This may break FIFO, we may want to add a lower limit check.
 
-        Helper * helper = new Helper(this, val);
+        Helper * helper = new Helper(this, val, val_seqid);
         uintptr_t helper_int = Helper::HelperType(helper);
 
         bool res = this->rb_->array_[pos].compare_exchange_strong(val, helper_int);
@@ -112,28 +112,28 @@ help_complete() {
       }  // its an EmptyType'
     }  // while notDone
   }  // while notDone
-}  // void RingBuffer<T>::DequeueOp::help_complete()
+}  // void RingBuffer<T, Role>::DequeueOp::help_complete()
 
-template<typename T>
+template<typename T, class Role>
 void *
-RingBuffer<T>::DequeueOp::
+RingBuffer<T, Role>::DequeueOp::
 associate(Helper *h) {
   bool res = BufferOp::privAssociate(h);
   int64_t seqid = -1;
   uintptr_t new_val;
   uintptr_t old_val = h->old_value_;
   if (res) {
-    seqid = RingBuffer<T>::getValueTypeSeqId(old_val);
+    seqid = h->seqid_;
     int64_t next_seqid = this->rb_->nextSeqId(seqid);
-    new_val = RingBuffer<T>::EmptyType(next_seqid);
-    if (RingBuffer<T>::isDelayedMarked(old_val)) {
-      new_val = RingBuffer<T>::DelayMarkValue(new_val);
+    new_val = RingBuffer<T, Role>::EmptyType(next_seqid);
+    if (RingBuffer<T, Role>::isDelayedMarked(old_val)) {
+      new_val = RingBuffer<T, Role>::DelayMarkValue(new_val);
     }
   } else {
     new_val = old_val;
     Helper *htemp = this->helper_.load();
     if (htemp != BufferOp::fail_val_) {
-      seqid = RingBuffer<T>::getEmptyTypeSeqId(htemp->old_value_);
+      seqid = htemp->seqid_;
     }
   }
   // Now we need to ensure the sequence counter does not false report full
@@ -152,9 +152,9 @@ associate(Helper *h) {
   return reinterpret_cast<void *>(new_val);
 }
 
-template<typename T>
+template<typename T, class Role>
 bool
-RingBuffer<T>::DequeueOp::
+RingBuffer<T, Role>::DequeueOp::
 result(T &val) {
   Helper * h;
   if (BufferOp::isFail(h)) {
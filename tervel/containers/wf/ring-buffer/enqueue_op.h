@@ -32,14 +32,13 @@ namespace containers {
 namespace wf {
 
 
-template<typename T>
-class RingBuffer<T>::EnqueueOp: public BufferOp {
+template<typename T, class Role>
+class RingBuffer<T, Role>::EnqueueOp: public BufferOp {
  public:
-  EnqueueOp(RingBuffer<T> *rb, T value)
+  EnqueueOp(RingBuffer<T, Role> *rb, T value)
     : BufferOp(rb)
     , value_(value) {
-      int64_t seqid = reinterpret_cast<int64_t>(this) * -1;
-      value_->func_seqid(seqid);
+      init_value(PackedType());
     }
 
   void * associate(Helper *h);
@@ -47,6 +46,20 @@ class RingBuffer<T>::EnqueueOp: public BufferOp {
   bool result();
 
  private:
+  // A value of pointer type is marked with the negated address of the op
+  // until it is assigned a seqid, an integral value has no seqid to mark.
+  void init_value(std::false_type) {
+    int64_t seqid = reinterpret_cast<int64_t>(this) * -1;
+    value_->func_seqid(seqid);
+  }
+  void init_value(std::true_type) {}
+
+  /**
+   * Returns the ValueType that places value_ at seqid.
+   */
+  uintptr_t associate_value(int64_t seqid, std::false_type);
+  uintptr_t associate_value(int64_t seqid, std::true_type);
+
   const T value_;
   DISALLOW_COPY_AND_ASSIGN(EnqueueOp);
 };
@@ -31,9 +31,9 @@ namespace tervel {
 namespace containers {
 namespace wf {
 
-template<typename T>
+template<typename T, class Role>
 void
-RingBuffer<T>::EnqueueOp::
+RingBuffer<T, Role>::EnqueueOp::
 help_complete() {
   int64_t tail = this->rb_->getTail();
   while(this->BufferOp::notDone()) {
@@ -53,7 +53,7 @@ help_complete() {
       int64_t val_seqid;
       bool val_isValueType;
       bool val_isDelayedMarked;
-      this->rb_->getInfo(val, val_seqid, val_isValueType, val_isDelayedMarked);
+      this->rb_->getInfo(val, seqid, val_seqid, val_isValueType, val_isDelayedMarked);
 
 
       if (val_seqid > tail) {
@@ -70,7 +70,7 @@ help_complete() {
       } else {
         // Its an EmptyType with a seqid <= to the one we are working with
         // so lets take it!
-        Helper * helper = new Helper(this, val);
+        Helper * helper = new Helper(this, val, val_seqid);
         uintptr_t helper_int = Helper::HelperType(helper);
 
         bool res = this->rb_->array_[pos].compare_exchange_strong(val, helper_int);
@@ -98,25 +98,19 @@ help_complete() {
   }
 }
 
-template<typename T>
+template<typename T, class Role>
 void*
-RingBuffer<T>::EnqueueOp::
+RingBuffer<T, Role>::EnqueueOp::
 associate(Helper *h) {
   bool res = BufferOp::privAssociate(h);
   uintptr_t new_val = h->old_value_;
   if (res) {
-    int64_t ev_seqid = reinterpret_cast<int64_t>(this) * -1;
-    int64_t seqid = this->rb_->getEmptyTypeSeqId(h->old_value_);
-    value_->atomic_change_seqid(ev_seqid, seqid);
-
-    uintptr_t temp = reinterpret_cast<uintptr_t>(value_);
-    assert((temp & clear_lsb) == 0 && " reserved bits are not 0?");
-    new_val = temp;
+    new_val = associate_value(h->seqid_, PackedType());
   }
   // Now we need to ensure the sequence counter does not false report
   // empty
   if (result()){
-    int64_t seqid = value_->func_seqid() + 1;
+    int64_t seqid = this->helper_.load()->seqid_ + 1;
     int64_t temp = this->rb_->getTail();
     while (temp < seqid) {
       if (this->rb_->casTail(temp, seqid))
@@ -128,9 +122,29 @@ associate(Helper *h) {
 }
 
 
-template<typename T>
+template<typename T, class Role>
+uintptr_t
+RingBuffer<T, Role>::EnqueueOp::
+associate_value(int64_t seqid, std::false_type) {
+  int64_t ev_seqid = reinterpret_cast<int64_t>(this) * -1;
+  value_->atomic_change_seqid(ev_seqid, seqid);
+
+  uintptr_t temp = reinterpret_cast<uintptr_t>(value_);
+  assert((temp & clear_lsb) == 0 && " reserved bits are not 0?");
+  return temp;
+}
+
+template<typename T, class Role>
+uintptr_t
+RingBuffer<T, Role>::EnqueueOp::
+associate_value(int64_t seqid, std::true_type) {
+  return this->rb_->ValueType(value_, seqid);
+}
+
+
+template<typename T, class Role>
 bool
-RingBuffer<T>::EnqueueOp::
+RingBuffer<T, Role>::EnqueueOp::
 result() {
   Helper * h;
   if (BufferOp::isFail(h)) {
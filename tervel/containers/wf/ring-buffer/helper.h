@@ -32,12 +32,13 @@ namespace tervel {
 namespace containers {
 namespace wf {
 
-template<typename T>
-class RingBuffer<T>::Helper : public tervel::util::memory::hp::Element {
+template<typename T, class Role>
+class RingBuffer<T, Role>::Helper : public tervel::util::memory::hp::Element {
  public:
-  Helper(BufferOp *op, uintptr_t old_value)
+  Helper(BufferOp *op, uintptr_t old_value, int64_t seqid)
    : op_(op)
-   , old_value_(old_value) {}
+   , old_value_(old_value)
+   , seqid_(seqid) {}
   ~Helper() {}
 
   bool on_watch(std::atomic<void *> *address, void *expected);
@@ -60,6 +61,9 @@ class RingBuffer<T>::Helper : public tervel::util::memory::hp::Element {
 
   BufferOp *op_;
   const uintptr_t old_value_;
+  // The seqid of old_value_, which for integral types can not be decoded
+  // without knowing its position.
+  const int64_t seqid_;
 
 };
 
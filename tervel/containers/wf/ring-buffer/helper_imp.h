@@ -34,9 +34,9 @@ namespace tervel {
 namespace containers {
 namespace wf {
 
-template<typename T>
+template<typename T, class Role>
 bool
-RingBuffer<T>::Helper::
+RingBuffer<T, Role>::Helper::
 on_watch(std::atomic<void *> *address, void *expected) {
   typedef tervel::util::memory::hp::HazardPointer::SlotID SlotID;
   SlotID pos = SlotID::SHORTUSE2;
@@ -51,7 +51,7 @@ on_watch(std::atomic<void *> *address, void *expected) {
   if (!res) {
     // we failed, could be because of delayed mark.
     void *temp = reinterpret_cast<void *>(
-        RingBuffer<T>::DelayMarkValue(HelperType(this)));
+        RingBuffer<T, Role>::DelayMarkValue(HelperType(this)));
     if (expected == temp) {
       address->compare_exchange_strong(expected, val);
     }
@@ -62,51 +62,51 @@ on_watch(std::atomic<void *> *address, void *expected) {
     assert(expected != reinterpret_cast<void *>(HelperType(this)));
     assert(expected !=
         reinterpret_cast<void *>(
-          RingBuffer<T>::DelayMarkValue(HelperType(this))));
+          RingBuffer<T, Role>::DelayMarkValue(HelperType(this))));
   #endif
   tervel::util::memory::hp::HazardPointer::unwatch(pos);
 
   return false;
 }
 
-template<typename T>
+template<typename T, class Role>
 void *
-RingBuffer<T>::Helper::
+RingBuffer<T, Role>::Helper::
 associate() {
   return op_->associate(this);
 }
 
-template<typename T>
+template<typename T, class Role>
 bool
-RingBuffer<T>::Helper::
+RingBuffer<T, Role>::Helper::
 valid() {
   return op_->valid(this);
 }
 
-template<typename T>
+template<typename T, class Role>
 uintptr_t
-RingBuffer<T>::Helper::
+RingBuffer<T, Role>::Helper::
 HelperType(Helper *h) {
   uintptr_t res = reinterpret_cast<uintptr_t>(h);
-  res = res | RingBuffer<T>::oprec_lsb; // 3LSB now 100
+  res = res | RingBuffer<T, Role>::oprec_lsb; // 3LSB now 100
   return res;
 }
 
-template<typename T>
+template<typename T, class Role>
 bool
-RingBuffer<T>::Helper::
+RingBuffer<T, Role>::Helper::
 isHelperType(uintptr_t val) {
-  val = val & RingBuffer<T>::oprec_lsb;
+  val = val & RingBuffer<T, Role>::oprec_lsb;
   return (val != 0);
 }
 
 
-template<typename T>
-typename RingBuffer<T>::Helper *
-RingBuffer<T>::Helper::
+template<typename T, class Role>
+typename RingBuffer<T, Role>::Helper *
+RingBuffer<T, Role>::Helper::
 getHelperType(uintptr_t val) {
-  val = val & (~RingBuffer<T>::oprec_lsb);  // clear oprec_lsb
-  val = val & (~RingBuffer<T>::delayMark_lsb);  // clear delayMark_lsb
+  val = val & (~RingBuffer<T, Role>::oprec_lsb);  // clear oprec_lsb
+  val = val & (~RingBuffer<T, Role>::delayMark_lsb);  // clear delayMark_lsb
   return reinterpret_cast<Helper *>(val);
 }
 
@@ -35,18 +35,26 @@ THE SOFTWARE.
 #ifndef TERVEL_CONTAINERS_WF_RINGBUFFER_RINGBUFFER_H_
 #define TERVEL_CONTAINERS_WF_RINGBUFFER_RINGBUFFER_H_
 
+#include <algorithm>
 #include <atomic>
 #include <assert.h>
+#include <chrono>
 #include <cstddef>
 #include <memory>
 #include <thread>
 #include <string>
+#include <type_traits>
 
+#include <tervel/util/event_count.h>
 #include <tervel/util/info.h>
 #include <tervel/util/util.h>
+#include <tervel/util/padded_atomic.h>
 #include <tervel/util/progress_assurance.h>
+#include <tervel/util/system.h>
 #include <tervel/util/memory/hp/hazard_pointer.h>
 
+#include <tervel/containers/wf/ring-buffer/buffer_role.h>
+
 namespace tervel {
 namespace containers {
 namespace wf {
@@ -60,16 +68,27 @@ namespace wf {
  * by hazard pointer protection.
  *
  * @details This ring buffer is implemented on a statically sized array.
- * It can only store pointer sized objects that extend the Value class.
+ * It stores either pointers to objects that extend the Value class, which
+ * hold the seqid of the value, or integral values of up to 32 bits, which are
+ * packed into the position next to the lap of their seqid so that enqueueing
+ * them does not require an allocation.
  * Further it reserves the 3 LSB for type identification, which makes it
  * compatible only with 64 bit systems
  *
  * It supports enqueue, dequeue, isFull, and isEmpty operations
  *
- * @tparam T The type of information stored, must be a pointer and the class
- * must extend RingBuffer::Value.
+ * If a side of the buffer has a single thread, see buffer_role.h, that side
+ * takes its seqids with a load and a store of its counter instead of a
+ * fetch-and-add, and does not make announcements, as no other thread of its
+ * side can delay it. Its operations are then lock-free rather than wait-free
+ * with respect to the other side. A buffer with a single producer and a
+ * single consumer is implemented separately, see spsc_ring_buffer.h.
+ *
+ * @tparam T The type of information stored, either a pointer whose class
+ * extends RingBuffer::Value or an integral type of at most 32 bits.
+ * @tparam Role The threads that may use each side, see buffer_role.h.
  */
-template<typename T>
+template<typename T, class Role = buffer_role::MPMC>
 class RingBuffer {
   static const uintptr_t num_lsb = 3;
   static const uintptr_t delayMark_lsb = 0x1;
@@ -77,8 +96,17 @@ class RingBuffer {
   static const uintptr_t oprec_lsb = 0x4;
   static const uintptr_t clear_lsb = 7;
 
-  static_assert(sizeof(T) == sizeof(uintptr_t) &&
-    sizeof(uintptr_t) == sizeof(uint64_t), " Pointers muse be 64 bits");
+  // Integral values are stored in the position itself, see ValueType.
+  static const bool kPacked = std::is_integral<T>::value;
+  typedef std::integral_constant<bool, kPacked> PackedType;
+  static const uintptr_t kPayloadBits = kPacked ? sizeof(T) * 8 : 0;
+  static const uintptr_t kLapBits = 64 - num_lsb - kPayloadBits;
+
+  static_assert(sizeof(uintptr_t) == sizeof(uint64_t),
+    " Pointers muse be 64 bits");
+  static_assert(kPacked ? sizeof(T) <= sizeof(uint32_t) :
+    (std::is_pointer<T>::value && sizeof(T) == sizeof(uintptr_t)),
+    " T must be a pointer or an integral type of at most 32 bits");
 
  public:
   /**
@@ -96,7 +124,8 @@ class RingBuffer {
      * @details Empty Constructor
      */
     Value() {};
-    friend RingBuffer;
+    // Any role may use a value class, whichever RingBuffer it extends.
+    template<typename, class> friend class RingBuffer;
    private:
     /**
      * @brief Returns the items seqid
@@ -138,7 +167,8 @@ class RingBuffer {
    * @brief Ring Buffer constructor
    * @details This constructs and initializes the ring buffer object
    *
-   * @param capacity the length of the internal array to allocate.
+   * @param capacity the length of the internal array to allocate, rounded up
+   * to a power of two so positions are computed with a mask.
    */
   RingBuffer(size_t capacity);
 
@@ -199,6 +229,68 @@ class RingBuffer {
    */
   bool dequeue(T &value);
 
+  /**
+   * @brief Enqueues up to n values with a single update of the tail counter
+   * @details This function reserves a range of sequence ids for as many of
+   * the values as there is room for, then places each value at the next
+   * position of the range. If other producers keep moving the tail, it gives
+   * up on the range after TERVEL_RINGBUFFER_BULK_ATTEMPTS tries and enqueues
+   * the values one at a time. A position that can not be used, for example
+   * because a dequeue of the previous lap has not completed, passes its value
+   * on to the next position. Values left over at the end of the range are
+   * enqueued one at a time, as by enqueue.
+   *
+   * The values are enqueued in order, but values enqueued concurrently by
+   * other threads may be interleaved with them.
+   *
+   * @param values The values to enqueue.
+   * @param n The number of values.
+   * @return the number of values enqueued, values[0] through values[res-1].
+   */
+  size_t enqueue_bulk(T *values, size_t n);
+
+  /**
+   * @brief Dequeues up to max values with a single update of the head counter
+   * @details This function reserves a range of sequence ids for as many values
+   * as the buffer holds, up to max, then takes the value at each position of
+   * the range. Positions whose values have not arrived yet are made up for
+   * with single dequeues, as by dequeue. If other consumers keep moving the
+   * head, it gives up on the range after TERVEL_RINGBUFFER_BULK_ATTEMPTS
+   * tries and dequeues the values one at a time.
+   *
+   * @param values An array of at least max elements to store the values in.
+   * @param max The maximum number of values to dequeue.
+   * @return the number of values dequeued, in FIFO order.
+   */
+  size_t dequeue_bulk(T *values, size_t max);
+
+  /**
+   * @brief Enqueues the passed value, waiting while the buffer is full
+   * @details This function retries enqueue TERVEL_RINGBUFFER_WAIT_SPIN times
+   * and then sleeps on a futex until a dequeue makes room or the timeout
+   * expires. Operations only wake sleepers when some thread is waiting, so
+   * the other operations pay a single load for this.
+   *
+   * @param value The value to enqueue.
+   * @param timeout The longest time to wait, by default forever.
+   * @return whether or not the value was enqueued.
+   */
+  bool enqueue_wait(T value, std::chrono::nanoseconds timeout =
+    std::chrono::nanoseconds::max());
+
+  /**
+   * @brief Dequeues a value, waiting while the buffer is empty
+   * @details This function retries dequeue TERVEL_RINGBUFFER_WAIT_SPIN times
+   * and then sleeps on a futex until an enqueue adds a value or the timeout
+   * expires, see enqueue_wait.
+   *
+   * @param value A variable to store the dequeued value.
+   * @param timeout The longest time to wait, by default forever.
+   * @return whether or not a value was dequeued.
+   */
+  bool dequeue_wait(T &value, std::chrono::nanoseconds timeout =
+    std::chrono::nanoseconds::max());
+
   /**
    * @brief This function returns a string debugging information
    * @details This information includes
@@ -225,6 +317,34 @@ class RingBuffer {
    */
   bool readValue(int64_t pos, uintptr_t &val);
 
+  /**
+   * @brief Attempts to place value at the position of seqid
+   * @details This is the body of enqueue once a seqid has been taken from the
+   * tail counter.
+   *
+   * @param seqid the sequence id assigned to value.
+   * @param value the value to enqueue.
+   * @param progAssur the limit of the calling operation.
+   *
+   * @return whether or not value was placed, if not a new seqid is needed.
+   */
+  bool enqueueAt(int64_t seqid, T value,
+    util::ProgressAssurance::Limit &progAssur);
+
+  /**
+   * @brief Attempts to take the value with sequence id seqid
+   * @details This is the body of dequeue once a seqid has been taken from the
+   * head counter.
+   *
+   * @param seqid the sequence id to dequeue.
+   * @param value a variable to store the dequeued value.
+   * @param progAssur the limit of the calling operation.
+   *
+   * @return whether or not a value was dequeued, if not a new seqid is needed.
+   */
+  bool dequeueAt(int64_t seqid, T &value,
+    util::ProgressAssurance::Limit &progAssur);
+
   /**
    * @brief Creates a uintptr_t that represents an EmptyType
    * @details the uintptr_t is composed by
@@ -248,35 +368,54 @@ class RingBuffer {
 
   /**
    * @brief Creates a uintptr_t that represents an ValueType
-   * @details the uintptr_t is composed by casting value to a uintptr_t.
+   * @details For pointer types the uintptr_t is composed by casting value to
+   * a uintptr_t, internally it calls value->func_seqid(seqid) to set the
+   * seqid.
    *
-   * Internally it calls value->func_seqid(seqid) to set the seqid.
+   * For integral types it is composed by
+   * lap << (num_lsb + kPayloadBits) | value << num_lsb
+   * where lap is seqid / capacity_ truncated to kLapBits. The position
+   * supplies the rest of the seqid, see getValueTypeSeqId.
    *
-   * @param value a pointer type to enqueue
+   * @param value the value to enqueue
    * @param seqid the sequence id assigned to this value
    * @return Returns uintptr_t that represents an ValueType
    */
-  static inline uintptr_t ValueType(T value, int64_t seqid);
+  inline uintptr_t ValueType(T value, int64_t seqid);
+  inline uintptr_t ValueType(T value, int64_t seqid, std::false_type);
+  inline uintptr_t ValueType(T value, int64_t seqid, std::true_type);
 
   /**
    * @brief Returns the value type from a uintptr
-   * @details clears any delayed marks then casts it to type T.
+   * @details clears any delayed marks then casts it to type T, or for
+   * integral types extracts the packed value.
    *
    * @param val The value to cast
    * @return val cast to type T
    */
   static inline T getValueType(uintptr_t val);
+  static inline T getValueType(uintptr_t val, std::false_type);
+  static inline T getValueType(uintptr_t val, std::true_type);
 
   /**
    * @brief Returns the seqid of the passed value
-   * @details Returns the seqid of the passed value, first it casts val to type
-   * T by calling getValyeType then it calls val->func_seqid();
+   * @details For pointer types it casts val to type T by calling
+   * getValueType then it calls val->func_seqid().
+   *
+   * For integral types the lap stored in val is widened to the lap closest
+   * to that of seqid, which is correct as long as no thread lags 2^(kLapBits-1)
+   * laps behind the buffer.
    *
    * @param val a value read from the ring buffer that has been determined to
    * be a ValueType
+   * @param seqid any seqid that belongs at the position val was read from
    * @return The values seqid
    */
-  static inline int64_t getValueTypeSeqId(uintptr_t val);
+  inline int64_t getValueTypeSeqId(uintptr_t val, int64_t seqid);
+  inline int64_t getValueTypeSeqId(uintptr_t val, int64_t seqid,
+    std::false_type);
+  inline int64_t getValueTypeSeqId(uintptr_t val, int64_t seqid,
+    std::true_type);
 
   /**
    * @brief Takes a uintptr_t and places a bitmark on the delayMark_lsb
@@ -294,11 +433,12 @@ class RingBuffer {
    * ring buffer. This information is then assigned to the arguments.
    *
    * @param val a value read from a position on the ring buffer
+   * @param seqid any seqid that belongs at the position val was read from
    * @param val_seqid The seqid associated with val
    * @param val_isValueType Whether or not val is a ValueType
    * @param val_isMarked Whether or not val has a delay mark.
    */
-  void getInfo(uintptr_t val, int64_t &val_seqid,
+  void getInfo(uintptr_t val, int64_t seqid, int64_t &val_seqid,
     bool &val_isValueType, bool &val_isMarked);
 
   /**
@@ -340,7 +480,8 @@ class RingBuffer {
 
   /**
    * @brief performs an atomic load on the head counter
-   * @details performs an atomic load on the head counter
+   * @details performs an atomic load on the head counter, without writing to
+   * its cache line.
    * @return returns the value of the head counter.
    */
   int64_t getHead();
@@ -356,7 +497,8 @@ class RingBuffer {
 
   /**
    * @brief performs an atomic load on the tail counter
-   * @details performs an atomic load on the tail counter
+   * @details performs an atomic load on the tail counter, without writing to
+   * its cache line.
    * @return returns the value of the tail counter.
    */
   int64_t getTail();
@@ -374,6 +516,45 @@ class RingBuffer {
    */
   static inline int64_t counterAction(std::atomic<int64_t> &counter, int64_t val);
 
+  /**
+   * @brief Takes val seqids from counter
+   * @details Calls counterAction if multiple threads use the side of the
+   * counter, otherwise the calling thread owns the counter and it is updated
+   * with a store.
+   *
+   * @param counter the counter of the calling thread's side
+   * @param val the number of seqids to take
+   *
+   * @return the first seqid taken.
+   */
+  static inline int64_t claim(util::PaddedAtomic<int64_t> &counter,
+    int64_t val, std::true_type);
+  static inline int64_t claim(util::PaddedAtomic<int64_t> &counter,
+    int64_t val, std::false_type);
+
+  /**
+   * @brief Takes the count seqids from first, if first is still the counter's
+   * value
+   * @details Used by the bulk operations, which compute count from first, so
+   * that count never exceeds the values or the room there are once it is
+   * taken. Where only the calling thread updates the counter it always
+   * succeeds.
+   *
+   * @param counter the counter of the calling thread's side
+   * @param first the value read from counter, set to its current value if it
+   * has changed
+   * @param count the number of seqids to take
+   *
+   * @return whether the seqids were taken.
+   */
+  static inline bool claimRange(util::PaddedAtomic<int64_t> &counter,
+    int64_t &first, int64_t count, std::true_type);
+  static inline bool claimRange(util::PaddedAtomic<int64_t> &counter,
+    int64_t &first, int64_t count, std::false_type);
+
+  typedef std::integral_constant<bool, Role::kMultiProducer> MultiProducer;
+  typedef std::integral_constant<bool, Role::kMultiConsumer> MultiConsumer;
+
   /**
    * @brief Returns the next seqid
    * @details Returns the next seqid, which is seqid+capacity_
@@ -386,13 +567,26 @@ class RingBuffer {
   /**
    * @brief Returns the position a seqid belongs at
    * @details Returns the position a seqid belongs at, determined by
-   * seqid % capacity_
+   * seqid % capacity_, computed as seqid & (capacity_ - 1).
+   *
+   * If TERVEL_RINGBUFFER_REMAP is defined the index is then transposed so
+   * that consecutive seqids fall on different cache lines: index i is placed
+   * at line i % lines, slot i / lines.
    *
    * @param seqid the seqid
    * @return the position the seqid belongs at
    */
   int64_t getPos(int64_t seqid);
 
+  /**
+   * @brief The inverse of getPos within a lap
+   * @details Returns the index in [0, capacity_) whose seqids belong at pos.
+   *
+   * @param pos a position of the buffer
+   * @return seqid % capacity_ of the seqids that belong at pos
+   */
+  int64_t getIndex(int64_t pos);
+
   /**
    * @brief A backoff routine in the event of thread delay
    * @details This function is called in the event the value at position on the
@@ -425,9 +619,12 @@ class RingBuffer {
    * @details This prints out debugging information.
    *
    * @param val a value loaded from a position on the buffer
+   * @param seqid a seqid that belongs at the position val was loaded from
    * @return a string representation the contents of val.
    */
-  std::string debug_string(uintptr_t val);
+  std::string debug_string(uintptr_t val, int64_t seqid);
+  static std::string debug_string(T value, std::false_type);
+  static std::string debug_string(T value, std::true_type);
 
 
   class BufferOp;
@@ -435,11 +632,27 @@ class RingBuffer {
   class DequeueOp;
   class Helper;
 
+  static const int64_t kSlotsPerLine = CACHE_LINE_SIZE / sizeof(uintptr_t);
+
   const int64_t capacity_;
-  std::atomic<int64_t> head_ {0};
-  std::atomic<int64_t> tail_ {0};
+  const int64_t capacity_mask_;
+  // log2(capacity_), seqid >> lap_shift_ is the lap of a seqid.
+  const int64_t lap_shift_;
+  // The number of cache lines of the array - 1 and its log2, used by getPos
+  // when TERVEL_RINGBUFFER_REMAP is defined.
+  const int64_t line_mask_;
+  const int64_t line_shift_;
   std::unique_ptr<std::atomic<uintptr_t>[]> array_;
 
+  // The fields above are read only, this keeps them off the counters' lines.
+  char padding_[CACHE_LINE_SIZE];
+  // Producers update tail_ and consumers head_, each on its own cache line.
+  util::PaddedAtomic<int64_t> head_ {0};
+  util::PaddedAtomic<int64_t> tail_ {0};
+  // Threads in dequeue_wait wait on not_empty_, in enqueue_wait on not_full_.
+  util::EventCount not_empty_;
+  util::EventCount not_full_;
+
 };  // class RingBuffer<Value>
 
 
@@ -459,5 +672,7 @@ class RingBuffer {
 
 #include <tervel/containers/wf/ring-buffer/ring_buffer_imp.h>
 
+#include <tervel/containers/wf/ring-buffer/spsc_ring_buffer.h>
+
 
 #endif  // TERVEL_CONTAINERS_WF_RINGBUFFER_RINGBUFFER_H_
\ No newline at end of file
@@ -29,51 +29,56 @@ namespace tervel {
 namespace containers {
 namespace wf {
 
-template<typename T>
-RingBuffer<T>::
+template<typename T, class Role>
+RingBuffer<T, Role>::
 RingBuffer(size_t capacity)
-  : capacity_(capacity)
-  , array_(new std::atomic<uintptr_t>[capacity]) {
-  for (uint64_t i = 0; i < capacity_; i++) {
-    array_[i].store(EmptyType(i));
+  : capacity_(int64_t(1) << util::round_to_next_power_of_two(capacity))
+  , capacity_mask_(capacity_ - 1)
+  , lap_shift_(util::round_to_next_power_of_two(capacity_))
+  , line_mask_(std::max(capacity_ / kSlotsPerLine, int64_t(1)) - 1)
+  , line_shift_(util::round_to_next_power_of_two(line_mask_ + 1))
+  , array_(new std::atomic<uintptr_t>[capacity_]) {
+  assert(capacity > 0);
+  for (int64_t i = 0; i < capacity_; i++) {
+    array_[getPos(i)].store(EmptyType(i));
   }
 }
 
-template<typename T>
-bool RingBuffer<T>::
+template<typename T, class Role>
+bool RingBuffer<T, Role>::
 isFull() {
-  return isFull(tail_.load(), head_.load());
+  return isFull(getTail(), getHead());
 }
 
-template<typename T>
-bool RingBuffer<T>::
+template<typename T, class Role>
+bool RingBuffer<T, Role>::
 isFull(int64_t tail, int64_t head) {
   int64_t temp = tail - head;
   return temp >= capacity_;
 }
 
 
-template<typename T>
-bool RingBuffer<T>::
+template<typename T, class Role>
+bool RingBuffer<T, Role>::
 isEmpty() {
-  return isEmpty(tail_.load(), head_.load());
+  return isEmpty(getTail(), getHead());
 }
 
-template<typename T>
-bool RingBuffer<T>::
+template<typename T, class Role>
+bool RingBuffer<T, Role>::
 isEmpty(int64_t tail, int64_t head) {
   int64_t temp = tail - head;
   return temp <= 0;
 }
 
-template<typename T>
-void RingBuffer<T>::
+template<typename T, class Role>
+void RingBuffer<T, Role>::
 atomic_delay_mark(int64_t pos) {
   array_[pos].fetch_or(delayMark_lsb);
 }
 
-template<typename T>
-bool RingBuffer<T>::
+template<typename T, class Role>
+bool RingBuffer<T, Role>::
 readValue(int64_t pos, uintptr_t &val) {
   val = array_[pos].load();
   if (Helper::isHelperType(val)) {
@@ -92,31 +97,56 @@ readValue(int64_t pos, uintptr_t &val) {
 }
 
 
-template<typename T>
-void RingBuffer<T>::
-getInfo(uintptr_t val, int64_t &val_seqid,
+template<typename T, class Role>
+void RingBuffer<T, Role>::
+getInfo(uintptr_t val, int64_t seqid, int64_t &val_seqid,
     bool &val_isValueType, bool &val_isDelayedMarked) {
   val_isValueType = isValueType(val);
   val_isDelayedMarked = isDelayedMarked(val);
   if (val_isValueType) {
-    val_seqid = getValueTypeSeqId(val);
+    val_seqid = getValueTypeSeqId(val, seqid);
   } else {
     val_seqid = getEmptyTypeSeqId(val);
   }
 }
 
-template<typename T>
-T RingBuffer<T>::
+template<typename T, class Role>
+T RingBuffer<T, Role>::
 getValueType(uintptr_t val) {
+  return getValueType(val, PackedType());
+}
+
+template<typename T, class Role>
+T RingBuffer<T, Role>::
+getValueType(uintptr_t val, std::false_type) {
   val = val & (~clear_lsb);  // ~clear_lsb == 111...000
   T temp = reinterpret_cast<T>(val);
   return temp;
 }
 
-template<typename T>
-bool RingBuffer<T>::
+template<typename T, class Role>
+T RingBuffer<T, Role>::
+getValueType(uintptr_t val, std::true_type) {
+  const uintptr_t payload_mask = (uintptr_t(1) << kPayloadBits) - 1;
+  return static_cast<T>((val >> num_lsb) & payload_mask);
+}
+
+template<typename T, class Role>
+bool RingBuffer<T, Role>::
 dequeue(T &value) {
   tervel::util::ProgressAssurance::check_for_announcement();
+  if (!Role::kMultiConsumer) {
+    // No other consumer can delay us, so there is no one to ask for help.
+    util::ProgressAssurance::Limit noLimit(-1);
+    while (!isEmpty()) {
+      if (dequeueAt(nextHead(), value, noLimit)) {
+        not_full_.notify(1);
+        return true;
+      }
+    }
+    return false;
+  }
+
   util::ProgressAssurance::Limit progAssur;
 
   while(progAssur.notDelayed(0)) {
@@ -125,97 +155,165 @@ dequeue(T &value) {
     }
 
     int64_t seqid = nextHead();
-    uint64_t pos = getPos(seqid);
-    uintptr_t val;
-    uintptr_t new_value = EmptyType(nextSeqId(seqid));
+    if (dequeueAt(seqid, value, progAssur)) {
+      not_full_.notify(1);
+      return true;
+    }
+  } // outer loop.
 
-    while (progAssur.notDelayed(1)) {
+  DequeueOp *op = new DequeueOp(this);
+  tervel::util::ProgressAssurance::make_announcement(op);
+  bool res = op->result(value);
+  op->safe_delete();
+  if (res) {
+    not_full_.notify(1);
+  }
+  return res;
+}
 
-      if (!readValue(pos, val)) {
-        continue;
-      }
 
-      int64_t val_seqid;
-      bool val_isValueType;
-      bool val_isDelayedMarked;
-      getInfo(val, val_seqid, val_isValueType, val_isDelayedMarked);
+template<typename T, class Role>
+bool RingBuffer<T, Role>::
+dequeueAt(int64_t seqid, T &value, util::ProgressAssurance::Limit &progAssur) {
+  uint64_t pos = getPos(seqid);
+  uintptr_t val;
+  uintptr_t new_value = EmptyType(nextSeqId(seqid));
 
-      if (val_seqid > seqid) {
-        break;
-      }
-      if (val_isValueType) {
-        if (val_seqid == seqid) {
-          if (val_isDelayedMarked) {
-            new_value = DelayMarkValue(new_value);
-            assert(isDelayedMarked(new_value));
-          }
-          value = getValueType(val);
-
-          uintptr_t sanity_check = val;
-          if (!array_[pos].compare_exchange_strong(val, new_value)) {
-            assert(!val_isDelayedMarked && "This value changed unexpectedly, it should only be changeable by this thread except for bit marking");
-            assert(DelayMarkValue(sanity_check) == val && "This value changed unexpectedly, it should only be changeable by this thread except for bit marking");
-            new_value =  DelayMarkValue(new_value);
-            bool res = array_[pos].compare_exchange_strong(val, new_value);
-            assert(res && " If this assert hits, then somehow another thread changed this value, when only this thread should be able to.");
-            // NOTE: These asserts should be disabled, when using progress assurance we allow for this to occur.
-            if (res == false) {
-              continue;
-            }
-          }
-          return true;
-        } else { // val_seqod < seqid
-          if (backoff(pos, val)) {
-            // value changed
-            continue; // process the new value.
-          }
-          // Value has not changed so lets skip it.
-          if (val_isDelayedMarked) {
-            // Its marked and the seqid is less than ours so we
-            // can skip it safely.
-            break;
-          } else {
-            // we blindly mark it and re-examine the value;
-            atomic_delay_mark(pos);
+  while (progAssur.notDelayed(1)) {
+
+    if (!readValue(pos, val)) {
+      continue;
+    }
+
+    int64_t val_seqid;
+    bool val_isValueType;
+    bool val_isDelayedMarked;
+    getInfo(val, seqid, val_seqid, val_isValueType, val_isDelayedMarked);
 
+    if (val_seqid > seqid) {
+      return false;
+    }
+    if (val_isValueType) {
+      if (val_seqid == seqid) {
+        if (val_isDelayedMarked) {
+          new_value = DelayMarkValue(new_value);
+          assert(isDelayedMarked(new_value));
+        }
+        value = getValueType(val);
+
+        uintptr_t sanity_check = val;
+        if (!array_[pos].compare_exchange_strong(val, new_value)) {
+          assert(!val_isDelayedMarked && "This value changed unexpectedly, it should only be changeable by this thread except for bit marking");
+          assert(DelayMarkValue(sanity_check) == val && "This value changed unexpectedly, it should only be changeable by this thread except for bit marking");
+          new_value =  DelayMarkValue(new_value);
+          bool res = array_[pos].compare_exchange_strong(val, new_value);
+          assert(res && " If this assert hits, then somehow another thread changed this value, when only this thread should be able to.");
+          // NOTE: These asserts should be disabled, when using progress assurance we allow for this to occur.
+          if (res == false) {
             continue;
           }
         }
-      } else { // val_isEmptyType
+        return true;
+      } else { // val_seqod < seqid
+        if (backoff(pos, val)) {
+          // value changed
+          continue; // process the new value.
+        }
+        // Value has not changed so lets skip it.
         if (val_isDelayedMarked) {
-          int64_t cur_head = getHead();
-          int64_t temp_pos = getPos(cur_head);
-          // We want to ensure that it has not been assigned.
-          // So we move it up a head.
-          cur_head += 2*capacity_ - temp_pos + pos;
-          uintptr_t temp = EmptyType(cur_head);
-          array_[pos].compare_exchange_strong(val, temp);
+          // Its marked and the seqid is less than ours so we
+          // can skip it safely.
+          return false;
+        } else {
+          // we blindly mark it and re-examine the value;
+          atomic_delay_mark(pos);
+
           continue;
         }
-        if (!backoff(pos, val)) {
-          // Value has not changed
-          if (array_[pos].compare_exchange_strong(val, new_value)) {
-            break;
-          }
-        }
-        // Value has changed
+      }
+    } else { // val_isEmptyType
+      if (val_isDelayedMarked) {
+        int64_t cur_head = getHead();
+        // We want to ensure that it has not been assigned.
+        // So we move it up a head, to the seqid of pos two laps on.
+        cur_head += 2*capacity_ - (cur_head & capacity_mask_) + getIndex(pos);
+        uintptr_t temp = EmptyType(cur_head);
+        array_[pos].compare_exchange_strong(val, temp);
         continue;
       }
-    }  // inner loop
-  } // outer loop.
+      if (!backoff(pos, val)) {
+        // Value has not changed
+        if (array_[pos].compare_exchange_strong(val, new_value)) {
+          return false;
+        }
+      }
+      // Value has changed
+      continue;
+    }
+  }  // inner loop
+  return false;
+}
 
-  DequeueOp *op = new DequeueOp(this);
-  tervel::util::ProgressAssurance::make_announcement(op);
-  bool res = op->result(value);
-  op->safe_delete();
+
+template<typename T, class Role>
+size_t RingBuffer<T, Role>::
+dequeue_bulk(T *values, size_t max) {
+  tervel::util::ProgressAssurance::check_for_announcement();
+
+  // count is computed from the head the range starts at, so it is at most
+  // the number of values when the range is taken. wanted is the number of
+  // values to dequeue singly if the range can not be taken.
+  int64_t first = getHead();
+  int64_t count = 0;
+  int64_t wanted;
+  for (int attempt = 0; ; attempt++) {
+    wanted = std::min(static_cast<int64_t>(max), getTail() - first);
+    if (wanted <= 0) {
+      return 0;
+    } else if (attempt == TERVEL_RINGBUFFER_BULK_ATTEMPTS) {
+      break;
+    } else if (claimRange(head_, first, wanted, MultiConsumer())) {
+      count = wanted;
+      break;
+    }
+  }
+
+  size_t res = 0;
+  for (int64_t seqid = first; seqid < first + count; seqid++) {
+    util::ProgressAssurance::Limit progAssur;
+    if (dequeueAt(seqid, values[res], progAssur)) {
+      res++;
+    }
+  }
+  if (res > 0) {
+    not_full_.notify(static_cast<int>(res));
+  }
+
+  // Positions whose enqueue had not completed or which were delayed are
+  // retried as single dequeues, which use progress assurance.
+  while (res < static_cast<size_t>(wanted) && dequeue(values[res])) {
+    res++;
+  }
   return res;
 }
 
 
-template<typename T>
-bool RingBuffer<T>::
+template<typename T, class Role>
+bool RingBuffer<T, Role>::
 enqueue(T value) {
   tervel::util::ProgressAssurance::check_for_announcement();
+  if (!Role::kMultiProducer) {
+    // No other producer can delay us, so there is no one to ask for help.
+    util::ProgressAssurance::Limit noLimit(-1);
+    while (!isFull()) {
+      if (enqueueAt(nextTail(), value, noLimit)) {
+        not_empty_.notify(1);
+        return true;
+      }
+    }
+    return false;
+  }
+
   util::ProgressAssurance::Limit progAssur;
 
   while(progAssur.notDelayed(0)) {
@@ -224,73 +322,194 @@ enqueue(T value) {
     }
 
     int64_t seqid = nextTail();
-    uint64_t pos = getPos(seqid);
-    uintptr_t val;
+    if (enqueueAt(seqid, value, progAssur)) {
+      not_empty_.notify(1);
+      return true;
+    }
+  }  // outer while(progAssur.notDelayed())
 
-    while (progAssur.notDelayed(1)) {
-      if (!readValue(pos, val)) {
-        continue;
-      }
+  EnqueueOp *op = new EnqueueOp(this, value);
+  tervel::util::ProgressAssurance::make_announcement(op);
+  bool res = op->result();
+  op->safe_delete();
+  if (res) {
+    not_empty_.notify(1);
+  }
+  return res;
 
-      int64_t val_seqid;
-      bool val_isValueType;
-      bool val_isDelayedMarked;
-      getInfo(val, val_seqid, val_isValueType, val_isDelayedMarked);
+}
 
-      if (val_seqid > seqid) {
-        break;
-      }
 
+template<typename T, class Role>
+bool RingBuffer<T, Role>::
+enqueueAt(int64_t seqid, T value, util::ProgressAssurance::Limit &progAssur) {
+  uint64_t pos = getPos(seqid);
+  uintptr_t val;
 
-      if (val_isDelayedMarked) {
-        // only a dequeue can update this value
-        // lets backoff and see if it changes
-        if (backoff(pos, val)) {
-          // the value changed
-          continue;
-        } else {
-          break; // get a new seqid
-        }
-      } else if (val_isValueType) {
+  while (progAssur.notDelayed(1)) {
+    if (!readValue(pos, val)) {
+      continue;
+    }
+
+    int64_t val_seqid;
+    bool val_isValueType;
+    bool val_isDelayedMarked;
+    getInfo(val, seqid, val_seqid, val_isValueType, val_isDelayedMarked);
+
+    if (val_seqid > seqid) {
+      return false;
+    }
+
+
+    if (val_isDelayedMarked) {
+      // only a dequeue can update this value
+      // lets backoff and see if it changes
+      if (backoff(pos, val)) {
+        // the value changed
+        continue;
+      } else {
+        return false; // get a new seqid
+      }
+    } else if (val_isValueType) {
+      if (backoff(pos, val)) {
+        // value changed
+        continue; // process the new value.
+      } else {
+        // Value has not changed so lets skip it.
+        return false;
+      }
+    } else { // is emptyType
+      if (val_seqid < seqid) {
         if (backoff(pos, val)) {
           // value changed
           continue; // process the new value.
-        } else {
-          // Value has not changed so lets skip it.
-          break;
         }
-      } else { // is emptyType
-        if (val_seqid < seqid) {
-          if (backoff(pos, val)) {
-            // value changed
-            continue; // process the new value.
-          }
-        }
-        // The current value is an EmptyType and its seqid is <= the assigned one.
-        uintptr_t new_value = ValueType(value, seqid);
-        if (array_[pos].compare_exchange_strong(val, new_value)) {
-          return true;
-        } else {
-          // The position was updated and the latest value assigned to val.
-          // So we need to reprocess it.
-          continue;
-        }
-
       }
-    }  // inner while(progAssur.notDelayed())
-  }  // outer while(progAssur.notDelayed())
+      // The current value is an EmptyType and its seqid is <= the assigned one.
+      uintptr_t new_value = ValueType(value, seqid);
+      if (array_[pos].compare_exchange_strong(val, new_value)) {
+        return true;
+      } else {
+        // The position was updated and the latest value assigned to val.
+        // So we need to reprocess it.
+        continue;
+      }
 
-  EnqueueOp *op = new EnqueueOp(this, value);
-  tervel::util::ProgressAssurance::make_announcement(op);
-  bool res = op->result();
-  op->safe_delete();
+    }
+  }  // inner while(progAssur.notDelayed())
+  return false;
+}
+
+
+template<typename T, class Role>
+size_t RingBuffer<T, Role>::
+enqueue_bulk(T *values, size_t n) {
+  tervel::util::ProgressAssurance::check_for_announcement();
+
+  // The head only moves forward, so the room computed from first is at most
+  // the room there is when the range is taken.
+  int64_t first = getTail();
+  int64_t count = 0;
+  int64_t wanted;
+  for (int attempt = 0; ; attempt++) {
+    wanted = std::min(static_cast<int64_t>(n),
+          capacity_ - (first - getHead()));
+    if (wanted <= 0) {
+      return 0;
+    } else if (attempt == TERVEL_RINGBUFFER_BULK_ATTEMPTS) {
+      break;
+    } else if (claimRange(tail_, first, wanted, MultiProducer())) {
+      count = wanted;
+      break;
+    }
+  }
+
+  // A value whose position could not be used moves on to the next position,
+  // so the values keep their order.
+  size_t res = 0;
+  for (int64_t seqid = first; seqid < first + count; seqid++) {
+    util::ProgressAssurance::Limit progAssur;
+    if (enqueueAt(seqid, values[res], progAssur)) {
+      res++;
+    }
+  }
+  if (res > 0) {
+    not_empty_.notify(static_cast<int>(res));
+  }
+
+  // Values left by skipped or delayed positions are enqueued singly, which
+  // uses progress assurance.
+  while (res < static_cast<size_t>(wanted) && enqueue(values[res])) {
+    res++;
+  }
   return res;
+}
+
+
+template<typename T, class Role>
+bool RingBuffer<T, Role>::
+enqueue_wait(T value, std::chrono::nanoseconds timeout) {
+  for (int i = 0; i < TERVEL_RINGBUFFER_WAIT_SPIN; i++) {
+    if (enqueue(value)) {
+      return true;
+    }
+  }
 
+  const bool forever = (timeout == std::chrono::nanoseconds::max());
+  const auto deadline = std::chrono::steady_clock::now() +
+      (forever ? std::chrono::nanoseconds(0) : timeout);
+  while (true) {
+    uint32_t key = not_full_.prepare_wait();
+    if (enqueue(value)) {
+      not_full_.cancel_wait();
+      return true;
+    }
+    std::chrono::nanoseconds remaining(-1);
+    if (!forever) {
+      remaining = deadline - std::chrono::steady_clock::now();
+      if (remaining.count() <= 0) {
+        not_full_.cancel_wait();
+        return false;
+      }
+    }
+    not_full_.wait(key, remaining);
+  }
 }
 
 
-template<typename T>
-int64_t RingBuffer<T>::counterAction(std::atomic<int64_t> &counter, int64_t val) {
+template<typename T, class Role>
+bool RingBuffer<T, Role>::
+dequeue_wait(T &value, std::chrono::nanoseconds timeout) {
+  for (int i = 0; i < TERVEL_RINGBUFFER_WAIT_SPIN; i++) {
+    if (dequeue(value)) {
+      return true;
+    }
+  }
+
+  const bool forever = (timeout == std::chrono::nanoseconds::max());
+  const auto deadline = std::chrono::steady_clock::now() +
+      (forever ? std::chrono::nanoseconds(0) : timeout);
+  while (true) {
+    uint32_t key = not_empty_.prepare_wait();
+    if (dequeue(value)) {
+      not_empty_.cancel_wait();
+      return true;
+    }
+    std::chrono::nanoseconds remaining(-1);
+    if (!forever) {
+      remaining = deadline - std::chrono::steady_clock::now();
+      if (remaining.count() <= 0) {
+        not_empty_.cancel_wait();
+        return false;
+      }
+    }
+    not_empty_.wait(key, remaining);
+  }
+}
+
+
+template<typename T, class Role>
+int64_t RingBuffer<T, Role>::counterAction(std::atomic<int64_t> &counter, int64_t val) {
   int64_t seqid = counter.fetch_add(val);
   uint64_t temp = ~0x0;
   temp = temp >> num_lsb;
@@ -300,104 +519,179 @@ int64_t RingBuffer<T>::counterAction(std::atomic<int64_t> &counter, int64_t val)
 }
 
 
-template<typename T>
-int64_t RingBuffer<T>::getHead() {
-  return counterAction(head_, 0);
+template<typename T, class Role>
+int64_t RingBuffer<T, Role>::claim(util::PaddedAtomic<int64_t> &counter,
+    int64_t val, std::true_type) {
+  return counterAction(counter.atomic, val);
+}
+
+template<typename T, class Role>
+int64_t RingBuffer<T, Role>::claim(util::PaddedAtomic<int64_t> &counter,
+    int64_t val, std::false_type) {
+  int64_t seqid = counter.load(std::memory_order_relaxed);
+  counter.store(seqid + val, std::memory_order_release);
+  return seqid;
+}
+
+
+template<typename T, class Role>
+bool RingBuffer<T, Role>::claimRange(util::PaddedAtomic<int64_t> &counter,
+    int64_t &first, int64_t count, std::true_type) {
+  return counter.compare_exchange_strong(first, first + count);
 }
 
-template<typename T>
-int64_t RingBuffer<T>::casHead(int64_t &expected, int64_t new_val) {
+template<typename T, class Role>
+bool RingBuffer<T, Role>::claimRange(util::PaddedAtomic<int64_t> &counter,
+    int64_t &first, int64_t count, std::false_type) {
+  counter.store(first + count, std::memory_order_release);
+  return true;
+}
+
+
+template<typename T, class Role>
+int64_t RingBuffer<T, Role>::getHead() {
+  return head_.load();
+}
+
+template<typename T, class Role>
+int64_t RingBuffer<T, Role>::casHead(int64_t &expected, int64_t new_val) {
   return head_.compare_exchange_strong(expected, new_val);
 }
 
-template<typename T>
-int64_t RingBuffer<T>::nextHead() {
-  return counterAction(head_, 1);
+template<typename T, class Role>
+int64_t RingBuffer<T, Role>::nextHead() {
+  return claim(head_, 1, MultiConsumer());
 }
 
 
-template<typename T>
-int64_t RingBuffer<T>::getTail() {
-  return counterAction(tail_, 0);
+template<typename T, class Role>
+int64_t RingBuffer<T, Role>::getTail() {
+  return tail_.load();
 }
 
-template<typename T>
-int64_t RingBuffer<T>::casTail(int64_t &expected, int64_t new_val) {
+template<typename T, class Role>
+int64_t RingBuffer<T, Role>::casTail(int64_t &expected, int64_t new_val) {
   return tail_.compare_exchange_strong(expected, new_val);
 }
 
-template<typename T>
-int64_t RingBuffer<T>::nextTail() {
-  return counterAction(tail_, 1);
+template<typename T, class Role>
+int64_t RingBuffer<T, Role>::nextTail() {
+  return claim(tail_, 1, MultiProducer());
 }
 
 
 
 
-template<typename T>
-uintptr_t RingBuffer<T>::EmptyType(int64_t seqid) {
+template<typename T, class Role>
+uintptr_t RingBuffer<T, Role>::EmptyType(int64_t seqid) {
   uintptr_t res = seqid;
   res = res << num_lsb; // 3LSB now 000
   res = res | emptytype_lsb; // 3LSB now 010
   return res;
 }
 
-template<typename T>
-uintptr_t RingBuffer<T>::ValueType(T value, int64_t seqid) {
+template<typename T, class Role>
+uintptr_t RingBuffer<T, Role>::ValueType(T value, int64_t seqid) {
+  return ValueType(value, seqid, PackedType());
+}
+
+template<typename T, class Role>
+uintptr_t RingBuffer<T, Role>::ValueType(T value, int64_t seqid, std::false_type) {
   value->func_seqid(seqid);
   uintptr_t res = reinterpret_cast<uintptr_t>(value);
   assert((res & clear_lsb) == 0 && " reserved bits are not 0?");
   return res;
 }
 
-template<typename T>
-uintptr_t RingBuffer<T>::DelayMarkValue(uintptr_t val) {
+template<typename T, class Role>
+uintptr_t RingBuffer<T, Role>::ValueType(T value, int64_t seqid, std::true_type) {
+  const uintptr_t payload_mask = (uintptr_t(1) << kPayloadBits) - 1;
+  uintptr_t lap = static_cast<uintptr_t>(seqid >> lap_shift_);
+  uintptr_t res = lap << (num_lsb + kPayloadBits);
+  res = res | ((static_cast<uintptr_t>(value) & payload_mask) << num_lsb);
+  return res;  // 3LSB now 000
+}
+
+template<typename T, class Role>
+uintptr_t RingBuffer<T, Role>::DelayMarkValue(uintptr_t val) {
   val = val | delayMark_lsb; // 3LSB now X1X
   return val;
 }
 
-template<typename T>
-int64_t RingBuffer<T>::getEmptyTypeSeqId(uintptr_t val) {
+template<typename T, class Role>
+int64_t RingBuffer<T, Role>::getEmptyTypeSeqId(uintptr_t val) {
   int64_t res = (val >> num_lsb);
   return res;
 }
-template<typename T>
-int64_t RingBuffer<T>::getValueTypeSeqId(uintptr_t val) {
+template<typename T, class Role>
+int64_t RingBuffer<T, Role>::getValueTypeSeqId(uintptr_t val, int64_t seqid) {
+  return getValueTypeSeqId(val, seqid, PackedType());
+}
+
+template<typename T, class Role>
+int64_t RingBuffer<T, Role>::getValueTypeSeqId(uintptr_t val, int64_t seqid,
+    std::false_type) {
   T temp = getValueType(val);
   int64_t res = temp->func_seqid();
   return res;
 }
 
-template<typename T>
-bool RingBuffer<T>::isEmptyType(uintptr_t p) {
+template<typename T, class Role>
+int64_t RingBuffer<T, Role>::getValueTypeSeqId(uintptr_t val, int64_t seqid,
+    std::true_type) {
+  const uintptr_t lap = val >> (num_lsb + kPayloadBits);
+  const int64_t seqid_lap = seqid >> lap_shift_;
+  // The difference of the laps modulo 2^kLapBits, sign extended.
+  const uintptr_t diff = (lap - static_cast<uintptr_t>(seqid_lap)) <<
+      (64 - kLapBits);
+  int64_t res = seqid_lap + (static_cast<int64_t>(diff) >> (64 - kLapBits));
+  res = (res << lap_shift_) | (seqid & capacity_mask_);
+  return res;
+}
+
+template<typename T, class Role>
+bool RingBuffer<T, Role>::isEmptyType(uintptr_t p) {
   return (p & emptytype_lsb) == emptytype_lsb;
 }
 
-template<typename T>
-bool RingBuffer<T>::isValueType(uintptr_t p) {
+template<typename T, class Role>
+bool RingBuffer<T, Role>::isValueType(uintptr_t p) {
   return !isEmptyType(p);
 }
 
-template<typename T>
-bool RingBuffer<T>::isDelayedMarked(uintptr_t p) {
+template<typename T, class Role>
+bool RingBuffer<T, Role>::isDelayedMarked(uintptr_t p) {
   return (p & delayMark_lsb) == delayMark_lsb;
 }
 
-template<typename T>
-intptr_t RingBuffer<T>::nextSeqId(int64_t seqid) {
+template<typename T, class Role>
+intptr_t RingBuffer<T, Role>::nextSeqId(int64_t seqid) {
   return seqid + capacity_;
 }
 
-template<typename T>
-int64_t RingBuffer<T>::getPos(int64_t seqid) {
-  int64_t temp = seqid % capacity_;
-  assert(temp >= 0);
+template<typename T, class Role>
+int64_t RingBuffer<T, Role>::getPos(int64_t seqid) {
+  assert(seqid >= 0);
+  int64_t temp = seqid & capacity_mask_;
+#ifdef TERVEL_RINGBUFFER_REMAP
+  temp = (temp & line_mask_) * kSlotsPerLine + (temp >> line_shift_);
+#endif
   assert(temp < capacity_);
   return temp;
 }
 
-template<typename T>
-bool RingBuffer<T>::backoff(int64_t pos, uintptr_t val) {
+template<typename T, class Role>
+int64_t RingBuffer<T, Role>::getIndex(int64_t pos) {
+#ifdef TERVEL_RINGBUFFER_REMAP
+  if (line_mask_ > 0) {
+    return (pos % kSlotsPerLine) * (line_mask_ + 1) + pos / kSlotsPerLine;
+  }
+#endif
+  return pos;
+}
+
+template<typename T, class Role>
+bool RingBuffer<T, Role>::backoff(int64_t pos, uintptr_t val) {
   tervel::util::backoff();
   uintptr_t nval = array_[pos].load();
   if (nval == val) {
@@ -408,13 +702,13 @@ bool RingBuffer<T>::backoff(int64_t pos, uintptr_t val) {
 }
 
 
-template<typename T>
-std::string RingBuffer<T>::debug_string(uintptr_t val) {
+template<typename T, class Role>
+std::string RingBuffer<T, Role>::debug_string(uintptr_t val, int64_t seqid) {
   int64_t val_seqid;
 
   bool val_isValueType;
   bool val_isDelayedMarked;
-  getInfo(val, val_seqid, val_isValueType, val_isDelayedMarked);
+  getInfo(val, seqid, val_seqid, val_isValueType, val_isDelayedMarked);
 
   int64_t pos = getPos(val_seqid);
   std::string res = "{";
@@ -424,8 +718,7 @@ std::string RingBuffer<T>::debug_string(uintptr_t val) {
   res += "Pos: " + std::to_string(pos) + "\t";
   res += "}";
   if (val_isValueType) {
-    T temp = getValueType(val);
-    res += "[" + temp->toString() +"]";
+    res += "[" + debug_string(getValueType(val), PackedType()) +"]";
   }
   if (val_isDelayedMarked) {
     res += "*";
@@ -436,8 +729,18 @@ std::string RingBuffer<T>::debug_string(uintptr_t val) {
   return res;
 };
 
-template<typename T>
-std::string RingBuffer<T>::debug_string() {
+template<typename T, class Role>
+std::string RingBuffer<T, Role>::debug_string(T value, std::false_type) {
+  return value->toString();
+};
+
+template<typename T, class Role>
+std::string RingBuffer<T, Role>::debug_string(T value, std::true_type) {
+  return std::to_string(value);
+};
+
+template<typename T, class Role>
+std::string RingBuffer<T, Role>::debug_string() {
   std::string res = "";
 
   int64_t temp = head_.load();
@@ -460,7 +763,7 @@ std::string RingBuffer<T>::debug_string() {
   for (int  i = 0; i < capacity_; i++) {
     res += "[" + std::to_string(i) + "] ";
     uintptr_t val = array_[i].load();
-    res += debug_string(val);
+    res += debug_string(val, (temp & ~capacity_mask_) + getIndex(i));
     res += "\n";
   }
 
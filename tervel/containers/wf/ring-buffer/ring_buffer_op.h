@@ -40,10 +40,10 @@ namespace tervel {
 namespace containers {
 namespace wf {
 
-template<typename T>
-class RingBuffer<T>::BufferOp : public util::OpRecord {
+template<typename T, class Role>
+class RingBuffer<T, Role>::BufferOp : public util::OpRecord {
  public:
-  BufferOp(RingBuffer<T> *rb) {
+  BufferOp(RingBuffer<T, Role> *rb) {
     rb_ = rb;
   };
 
@@ -59,7 +59,7 @@ class RingBuffer<T>::BufferOp : public util::OpRecord {
   bool privAssociate(Helper *h) {
     Helper *temp = nullptr;
     bool res = helper_.compare_exchange_strong(temp, h);
-    if (res || temp == nullptr) { // success
+    if (res || temp == h) { // success, possibly by another thread resolving h
       return true;
     } else { // fail
       return false;
@@ -92,13 +92,17 @@ class RingBuffer<T>::BufferOp : public util::OpRecord {
   // are removed before removing the watch on the op record
 
  // private:
-  static constexpr Helper * fail_val_ = reinterpret_cast<Helper *>(0x1L);
+  static Helper * const fail_val_;
 
-  RingBuffer<T> * rb_;
+  RingBuffer<T, Role> * rb_;
   std::atomic<Helper *> helper_{nullptr};
   DISALLOW_COPY_AND_ASSIGN(BufferOp);
 };
 
+template<typename T, class Role>
+typename RingBuffer<T, Role>::Helper * const RingBuffer<T, Role>::BufferOp::fail_val_ =
+    reinterpret_cast<typename RingBuffer<T, Role>::Helper *>(0x1L);
+
 }  // namespace wf
 }  // namespace containers
 }  // namespace tervel
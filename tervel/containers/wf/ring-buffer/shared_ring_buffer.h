@@ -0,0 +1,227 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef TERVEL_CONTAINERS_WF_RINGBUFFER_SHARED_RINGBUFFER_H_
+#define TERVEL_CONTAINERS_WF_RINGBUFFER_SHARED_RINGBUFFER_H_
+
+#include <atomic>
+#include <assert.h>
+#include <cstddef>
+#include <new>
+#include <string>
+#include <type_traits>
+
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <tervel/util/util.h>
+#include <tervel/util/padded_atomic.h>
+#include <tervel/util/system.h>
+
+namespace tervel {
+namespace containers {
+namespace wf {
+
+/**
+ * @brief A FIFO ring buffer of integral values which lives in memory shared
+ * by several processes, such as a memfd or a /dev/shm file.
+ *
+ * @details The buffer, its counters and its positions are all stored in the
+ * mapping and hold no pointers, so each process may map it at a different
+ * address. Positions are encoded as in RingBuffer with integral values: an
+ * empty position holds the seqid it expects next, a full one holds the value
+ * packed next to the lap of its seqid. To pass a larger message, store it in
+ * the shared memory and enqueue its offset from the start of the mapping.
+ *
+ * A process creates the buffer with create, others map it with attach, and
+ * each calls detach when done with it. attach fails until the creator has
+ * finished initialising the buffer, or if it was created for a different T.
+ *
+ * The progress assurance of RingBuffer is not used, as the announcement
+ * table and the descriptors it places in positions are per process, so its
+ * operations are lock-free. The delay marks are kept, and they also let the
+ * buffer survive a process which dies in the middle of an operation:
+ *  - a position whose producer took a seqid but never wrote its value is
+ *    skipped by the consumer of that seqid after a backoff, as for a delayed
+ *    producer. Only the dead producer's value is lost.
+ *  - a value whose consumer took its seqid but never read it is delay marked
+ *    by the consumer which finds it a lap later, and taken by the consumer
+ *    which finds it two laps later, so it is delivered late rather than
+ *    occupying the position forever.
+ *
+ * @tparam T an integral type of at most 32 bits.
+ */
+template<typename T>
+class SharedRingBuffer {
+  static const uintptr_t num_lsb = 3;
+  static const uintptr_t delayMark_lsb = 0x1;
+  static const uintptr_t emptytype_lsb = 0x2;
+  static const uintptr_t kPayloadBits = sizeof(T) * 8;
+  static const uintptr_t kLapBits = 64 - num_lsb - kPayloadBits;
+
+  static_assert(std::is_integral<T>::value && sizeof(T) <= sizeof(uint32_t),
+    " T must be an integral type of at most 32 bits");
+  static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+    " 64 bit atomics must be lock-free to be shared between processes");
+
+  // Identifies an initialised buffer and the size of T it was created for.
+  static const uint64_t kMagic = 0x5465727665525342ULL ^ sizeof(T);
+
+ public:
+  /**
+   * @param capacity the number of positions, rounded up to a power of two.
+   * @return the number of bytes a buffer of that capacity occupies.
+   */
+  static size_t mapped_size(size_t capacity);
+
+  /**
+   * @brief Sizes the file to hold a buffer, maps it and initialises the
+   * buffer in it.
+   *
+   * @param fd a file descriptor of a memfd or shared memory file, opened for
+   * reading and writing.
+   * @param capacity the number of positions, rounded up to a power of two.
+   * @return the buffer in the calling process's mapping, or nullptr if the
+   * file could not be sized or mapped.
+   */
+  static SharedRingBuffer * create(int fd, size_t capacity);
+
+  /**
+   * @brief Maps a buffer created by another process.
+   *
+   * @param fd a file descriptor of the file passed to create.
+   * @return the buffer in the calling process's mapping, or nullptr if the
+   * file does not (yet) hold an initialised buffer of T.
+   */
+  static SharedRingBuffer * attach(int fd);
+
+  /**
+   * @brief Unmaps the buffer from the calling process, it must not be used
+   * by the process afterwards. The buffer remains valid for other processes.
+   */
+  void detach();
+
+  /**
+   * @return the number of processes which have the buffer mapped.
+   */
+  int64_t attached() {
+    return attached_.load();
+  }
+
+  /**
+   * @return whether or not the ring buffer is full.
+   */
+  bool isFull() {
+    return tail_.load() - head_.load() >= capacity_;
+  }
+
+  /**
+   * @return whether or not the ring buffer is empty.
+   */
+  bool isEmpty() {
+    return tail_.load() - head_.load() <= 0;
+  }
+
+  /**
+   * @brief Enqueues the passed value.
+   *
+   * @param value The value to enqueue.
+   * @return whether or not the value was enqueued, it is not if the buffer
+   * is full.
+   */
+  bool enqueue(T value);
+
+  /**
+   * @brief Dequeues a value.
+   *
+   * @param value A variable to store the dequeued value.
+   * @return whether or not a value was dequeued, it is not if the buffer is
+   * empty.
+   */
+  bool dequeue(T &value);
+
+  /**
+   * @return the head, tail and capacity.
+   */
+  std::string debug_string() {
+    return "Head: " + std::to_string(head_.load()) + "\n"
+        + "Tail: " + std::to_string(tail_.load()) + "\n"
+        + "capacity_: " + std::to_string(capacity_) + "\n"
+        + "attached_: " + std::to_string(attached_.load()) + "\n";
+  }
+
+ private:
+  explicit SharedRingBuffer(int64_t capacity);
+  ~SharedRingBuffer() {}
+
+  static size_t header_size();
+
+  std::atomic<uintptr_t> * positions() {
+    return reinterpret_cast<std::atomic<uintptr_t> *>(
+        reinterpret_cast<char *>(this) + header_size());
+  }
+
+  bool enqueueAt(int64_t seqid, T value);
+  bool dequeueAt(int64_t seqid, T &value);
+
+  /**
+   * @brief Waits and then checks whether the position still holds val.
+   * @return true if the value at pos changed.
+   */
+  bool backoff(int64_t pos, uintptr_t val);
+
+  inline uintptr_t EmptyType(int64_t seqid);
+  inline uintptr_t ValueType(T value, int64_t seqid);
+  inline T getValueType(uintptr_t val);
+  inline int64_t getEmptyTypeSeqId(uintptr_t val);
+  inline int64_t getValueTypeSeqId(uintptr_t val, int64_t seqid);
+  inline bool isEmptyType(uintptr_t val);
+  inline bool isDelayedMarked(uintptr_t val);
+
+  // Written last by create, with release order, see attach.
+  std::atomic<uint64_t> magic_ {0};
+  std::atomic<int64_t> attached_ {1};
+  const int64_t capacity_;
+  const int64_t capacity_mask_;
+  // log2(capacity_), seqid >> lap_shift_ is the lap of a seqid.
+  const int64_t lap_shift_;
+
+  // The fields above are read only, this keeps them off the counters' lines.
+  char padding_[CACHE_LINE_SIZE];
+  util::PaddedAtomic<int64_t> head_ {0};
+  util::PaddedAtomic<int64_t> tail_ {0};
+  // The positions follow, starting at header_size().
+
+  DISALLOW_COPY_AND_ASSIGN(SharedRingBuffer);
+};  // class SharedRingBuffer
+
+}  // namespace wf
+}  // namespace containers
+}  // namespace tervel
+
+#include <tervel/containers/wf/ring-buffer/shared_ring_buffer_imp.h>
+
+#endif  // TERVEL_CONTAINERS_WF_RINGBUFFER_SHARED_RINGBUFFER_H_
@@ -0,0 +1,310 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef TERVEL_CONTAINERS_WF_RINGBUFFER_SHARED_RINGBUFFER_IMP_H_
+#define TERVEL_CONTAINERS_WF_RINGBUFFER_SHARED_RINGBUFFER_IMP_H_
+
+namespace tervel {
+namespace containers {
+namespace wf {
+
+template<typename T>
+SharedRingBuffer<T>::
+SharedRingBuffer(int64_t capacity)
+  : capacity_(capacity)
+  , capacity_mask_(capacity - 1)
+  , lap_shift_(util::round_to_next_power_of_two(capacity)) {
+  std::atomic<uintptr_t> *array = positions();
+  for (int64_t i = 0; i < capacity_; i++) {
+    new (&array[i]) std::atomic<uintptr_t>(EmptyType(i));
+  }
+}
+
+template<typename T>
+size_t SharedRingBuffer<T>::
+header_size() {
+  return (sizeof(SharedRingBuffer<T>) + CACHE_LINE_SIZE - 1) /
+      CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+}
+
+template<typename T>
+size_t SharedRingBuffer<T>::
+mapped_size(size_t capacity) {
+  assert(capacity > 0);
+  const size_t length = size_t(1) << util::round_to_next_power_of_two(capacity);
+  return header_size() + length * sizeof(std::atomic<uintptr_t>);
+}
+
+template<typename T>
+SharedRingBuffer<T> * SharedRingBuffer<T>::
+create(int fd, size_t capacity) {
+  const size_t size = mapped_size(capacity);
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    return nullptr;
+  }
+  void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+      0);
+  if (memory == MAP_FAILED) {
+    return nullptr;
+  }
+
+  SharedRingBuffer<T> *buffer = new (memory) SharedRingBuffer<T>(
+      int64_t(1) << util::round_to_next_power_of_two(capacity));
+  buffer->magic_.store(kMagic, std::memory_order_release);
+  return buffer;
+}
+
+template<typename T>
+SharedRingBuffer<T> * SharedRingBuffer<T>::
+attach(int fd) {
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(SharedRingBuffer<T>)) {
+    return nullptr;
+  }
+  const size_t size = static_cast<size_t>(st.st_size);
+  void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+      0);
+  if (memory == MAP_FAILED) {
+    return nullptr;
+  }
+
+  SharedRingBuffer<T> *buffer = reinterpret_cast<SharedRingBuffer<T> *>(
+      memory);
+  if (buffer->magic_.load(std::memory_order_acquire) != kMagic ||
+      mapped_size(buffer->capacity_) != size) {
+    munmap(memory, size);
+    return nullptr;
+  }
+  buffer->attached_.fetch_add(1);
+  return buffer;
+}
+
+template<typename T>
+void SharedRingBuffer<T>::
+detach() {
+  attached_.fetch_sub(1);
+  munmap(reinterpret_cast<void *>(this), mapped_size(capacity_));
+}
+
+template<typename T>
+bool SharedRingBuffer<T>::
+enqueue(T value) {
+  while (!isFull()) {
+    int64_t seqid = tail_.fetch_add(1);
+    if (enqueueAt(seqid, value)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template<typename T>
+bool SharedRingBuffer<T>::
+enqueueAt(int64_t seqid, T value) {
+  std::atomic<uintptr_t> *array = positions();
+  const int64_t pos = seqid & capacity_mask_;
+
+  while (true) {
+    uintptr_t val = array[pos].load();
+    int64_t val_seqid = isEmptyType(val) ? getEmptyTypeSeqId(val) :
+        getValueTypeSeqId(val, seqid);
+
+    if (val_seqid > seqid) {
+      return false;
+    }
+
+    if (isDelayedMarked(val) || !isEmptyType(val)) {
+      // Only a dequeue can update this value, if it does not change the
+      // position is skipped.
+      if (backoff(pos, val)) {
+        continue;
+      }
+      return false;
+    }
+
+    if (val_seqid < seqid && backoff(pos, val)) {
+      continue;
+    }
+    // The current value is an EmptyType and its seqid is <= the assigned one.
+    if (array[pos].compare_exchange_strong(val, ValueType(value, seqid))) {
+      return true;
+    }
+  }  // while (true)
+}
+
+template<typename T>
+bool SharedRingBuffer<T>::
+dequeue(T &value) {
+  while (!isEmpty()) {
+    int64_t seqid = head_.fetch_add(1);
+    if (dequeueAt(seqid, value)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template<typename T>
+bool SharedRingBuffer<T>::
+dequeueAt(int64_t seqid, T &value) {
+  std::atomic<uintptr_t> *array = positions();
+  const int64_t pos = seqid & capacity_mask_;
+
+  while (true) {
+    uintptr_t val = array[pos].load();
+    const bool val_isDelayedMarked = isDelayedMarked(val);
+
+    if (isEmptyType(val)) {
+      int64_t val_seqid = getEmptyTypeSeqId(val);
+      if (val_seqid > seqid) {
+        return false;
+      }
+      if (val_isDelayedMarked) {
+        // Move it two laps on from the head, so that no producer which took
+        // a seqid before the mark uses it.
+        int64_t cur_head = head_.load();
+        cur_head += 2 * capacity_ - (cur_head & capacity_mask_) + pos;
+        array[pos].compare_exchange_strong(val, EmptyType(cur_head));
+        continue;
+      }
+      if (!backoff(pos, val)) {
+        // The producer of this seqid is delayed, or its process died, so
+        // the position is given to the next lap.
+        uintptr_t new_value = EmptyType(seqid + capacity_);
+        if (array[pos].compare_exchange_strong(val, new_value)) {
+          return false;
+        }
+      }
+      continue;
+    }
+
+    int64_t val_seqid = getValueTypeSeqId(val, seqid);
+    if (val_seqid > seqid) {
+      return false;
+    }
+
+    uintptr_t new_value = EmptyType(seqid + capacity_);
+    if (val_seqid == seqid) {
+      if (val_isDelayedMarked) {
+        // A consumer skipped this position, keep its mark so that the
+        // position is moved on.
+        new_value = new_value | delayMark_lsb;
+      }
+      if (array[pos].compare_exchange_strong(val, new_value)) {
+        value = getValueType(val);
+        return true;
+      }
+      // Only a delay mark could have been added.
+      continue;
+    }
+
+    // val_seqid < seqid, its consumer is delayed.
+    if (backoff(pos, val)) {
+      continue;
+    }
+    if (!val_isDelayedMarked) {
+      array[pos].fetch_or(delayMark_lsb);
+      continue;
+    }
+    if (seqid - val_seqid >= 2 * capacity_) {
+      // Its consumer has had two laps to take it, assume that its process
+      // died and take the value instead.
+      if (array[pos].compare_exchange_strong(val, new_value)) {
+        value = getValueType(val);
+        return true;
+      }
+      continue;
+    }
+    return false;
+  }  // while (true)
+}
+
+template<typename T>
+bool SharedRingBuffer<T>::
+backoff(int64_t pos, uintptr_t val) {
+  tervel::util::backoff();
+  return positions()[pos].load() != val;
+}
+
+template<typename T>
+uintptr_t SharedRingBuffer<T>::
+EmptyType(int64_t seqid) {
+  uintptr_t res = seqid;
+  res = res << num_lsb;  // 3LSB now 000
+  return res | emptytype_lsb;  // 3LSB now 010
+}
+
+template<typename T>
+uintptr_t SharedRingBuffer<T>::
+ValueType(T value, int64_t seqid) {
+  const uintptr_t payload_mask = (uintptr_t(1) << kPayloadBits) - 1;
+  uintptr_t lap = static_cast<uintptr_t>(seqid >> lap_shift_);
+  uintptr_t res = lap << (num_lsb + kPayloadBits);
+  res = res | ((static_cast<uintptr_t>(value) & payload_mask) << num_lsb);
+  return res;  // 3LSB now 000
+}
+
+template<typename T>
+T SharedRingBuffer<T>::
+getValueType(uintptr_t val) {
+  const uintptr_t payload_mask = (uintptr_t(1) << kPayloadBits) - 1;
+  return static_cast<T>((val >> num_lsb) & payload_mask);
+}
+
+template<typename T>
+int64_t SharedRingBuffer<T>::
+getEmptyTypeSeqId(uintptr_t val) {
+  return static_cast<int64_t>(val >> num_lsb);
+}
+
+template<typename T>
+int64_t SharedRingBuffer<T>::
+getValueTypeSeqId(uintptr_t val, int64_t seqid) {
+  const uintptr_t lap = val >> (num_lsb + kPayloadBits);
+  const int64_t seqid_lap = seqid >> lap_shift_;
+  // The difference of the laps modulo 2^kLapBits, sign extended.
+  const uintptr_t diff = (lap - static_cast<uintptr_t>(seqid_lap)) <<
+      (64 - kLapBits);
+  int64_t res = seqid_lap + (static_cast<int64_t>(diff) >> (64 - kLapBits));
+  return (res << lap_shift_) | (seqid & capacity_mask_);
+}
+
+template<typename T>
+bool SharedRingBuffer<T>::
+isEmptyType(uintptr_t val) {
+  return (val & emptytype_lsb) == emptytype_lsb;
+}
+
+template<typename T>
+bool SharedRingBuffer<T>::
+isDelayedMarked(uintptr_t val) {
+  return (val & delayMark_lsb) == delayMark_lsb;
+}
+
+}  // namespace wf
+}  // namespace containers
+}  // namespace tervel
+
+#endif  // TERVEL_CONTAINERS_WF_RINGBUFFER_SHARED_RINGBUFFER_IMP_H_
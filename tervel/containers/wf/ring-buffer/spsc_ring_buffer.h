@@ -0,0 +1,288 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef TERVEL_CONTAINERS_WF_RINGBUFFER_SPSC_RINGBUFFER_H_
+#define TERVEL_CONTAINERS_WF_RINGBUFFER_SPSC_RINGBUFFER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <assert.h>
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include <tervel/util/event_count.h>
+#include <tervel/util/util.h>
+#include <tervel/util/system.h>
+
+#include <tervel/containers/wf/ring-buffer/buffer_role.h>
+
+namespace tervel {
+namespace containers {
+namespace wf {
+
+template<typename T, class Role> class RingBuffer;
+
+/**
+ * @brief A FIFO ring buffer for a single producer and a single consumer.
+ *
+ * @details Each counter is written by only one thread, so a position is
+ * written by the producer and then released by a store to the tail, and read
+ * by the consumer and then released by a store to the head. No position is
+ * ever written by both, so the buffer needs no seqids, delay marks, CAS or
+ * progress assurance, and every operation is wait-free.
+ *
+ * Each side keeps the last value it read of the other side's counter, and
+ * only reads the counter again when that value says the buffer is full (or
+ * empty), so in steady state the sides do not touch each other's cache line.
+ *
+ * enqueue_wait and dequeue_wait sleep on an EventCount as for the other
+ * roles. The counters are only updated with release stores, so the fence a
+ * wake up needs is issued by the waiting side, see
+ * EventCount::waiter_barrier, and an update only pays a load of the
+ * EventCount's waiter count.
+ *
+ * It provides the same interface as the other roles. As no seqid is stored
+ * in the values, T may be any copyable type, RingBuffer::Value is provided so
+ * that value classes written for the other roles can be used unchanged.
+ *
+ * @tparam T The type of information stored.
+ */
+template<typename T>
+class RingBuffer<T, buffer_role::SPSC> {
+ public:
+  /**
+   * @brief An empty base class, values do not need to extend it.
+   */
+  class Value {
+   public:
+    Value() {};
+  };
+
+  /**
+   * @brief Ring Buffer constructor
+   *
+   * @param capacity the length of the internal array to allocate, rounded up
+   * to a power of two so positions are computed with a mask.
+   */
+  RingBuffer(size_t capacity)
+    : capacity_(int64_t(1) << util::round_to_next_power_of_two(capacity))
+    , capacity_mask_(capacity_ - 1)
+    , array_(new T[capacity_]) {
+    assert(capacity > 0);
+  }
+
+  /**
+   * @return whether or not the ring buffer is full.
+   */
+  bool isFull() {
+    return tail_.load() - head_.load() >= capacity_;
+  }
+
+  /**
+   * @return whether or not the ring buffer is empty.
+   */
+  bool isEmpty() {
+    return tail_.load() - head_.load() <= 0;
+  }
+
+  /**
+   * @brief Enqueues the passed value, must only be called by the producer.
+   *
+   * @param value The value to enqueue.
+   * @return whether or not the value was enqueued.
+   */
+  bool enqueue(T value) {
+    return enqueue_bulk(&value, 1) == 1;
+  }
+
+  /**
+   * @brief Dequeues a value, must only be called by the consumer.
+   *
+   * @param value A variable to store the dequeued value.
+   * @return whether or not a value was dequeued.
+   */
+  bool dequeue(T &value) {
+    return dequeue_bulk(&value, 1) == 1;
+  }
+
+  /**
+   * @brief Enqueues up to n values with a single update of the tail, must
+   * only be called by the producer.
+   *
+   * @param values The values to enqueue.
+   * @param n The number of values.
+   * @return the number of values enqueued, values[0] through values[res-1].
+   */
+  size_t enqueue_bulk(T *values, size_t n) {
+    const int64_t tail = tail_.load(std::memory_order_relaxed);
+    int64_t count = std::min(static_cast<int64_t>(n),
+          capacity_ - (tail - head_cache_));
+    if (count < static_cast<int64_t>(n)) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      count = std::min(static_cast<int64_t>(n),
+            capacity_ - (tail - head_cache_));
+    }
+    for (int64_t i = 0; i < count; i++) {
+      array_[(tail + i) & capacity_mask_] = values[i];
+    }
+    if (count > 0) {
+      tail_.store(tail + count, std::memory_order_release);
+      util::EventCount::notifier_barrier();
+      not_empty_.notify(static_cast<int>(count));
+    }
+    return static_cast<size_t>(count);
+  }
+
+  /**
+   * @brief Dequeues up to max values with a single update of the head, must
+   * only be called by the consumer.
+   *
+   * @param values An array of at least max elements to store the values in.
+   * @param max The maximum number of values to dequeue.
+   * @return the number of values dequeued, in FIFO order.
+   */
+  size_t dequeue_bulk(T *values, size_t max) {
+    const int64_t head = head_.load(std::memory_order_relaxed);
+    int64_t count = std::min(static_cast<int64_t>(max), tail_cache_ - head);
+    if (count < static_cast<int64_t>(max)) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      count = std::min(static_cast<int64_t>(max), tail_cache_ - head);
+    }
+    for (int64_t i = 0; i < count; i++) {
+      values[i] = array_[(head + i) & capacity_mask_];
+    }
+    if (count > 0) {
+      head_.store(head + count, std::memory_order_release);
+      util::EventCount::notifier_barrier();
+      not_full_.notify(static_cast<int>(count));
+    }
+    return static_cast<size_t>(count);
+  }
+
+  /**
+   * @brief Enqueues the passed value, waiting while the buffer is full, must
+   * only be called by the producer.
+   * @details This function retries enqueue TERVEL_RINGBUFFER_WAIT_SPIN times
+   * and then sleeps on a futex until a dequeue makes room or the timeout
+   * expires.
+   *
+   * @param value The value to enqueue.
+   * @param timeout The longest time to wait, by default forever.
+   * @return whether or not the value was enqueued.
+   */
+  bool enqueue_wait(T value, std::chrono::nanoseconds timeout =
+    std::chrono::nanoseconds::max()) {
+    return wait_for(not_full_, timeout, [&]() { return enqueue(value); });
+  }
+
+  /**
+   * @brief Dequeues a value, waiting while the buffer is empty, must only be
+   * called by the consumer.
+   * @details This function retries dequeue TERVEL_RINGBUFFER_WAIT_SPIN times
+   * and then sleeps on a futex until an enqueue adds a value or the timeout
+   * expires.
+   *
+   * @param value A variable to store the dequeued value.
+   * @param timeout The longest time to wait, by default forever.
+   * @return whether or not a value was dequeued.
+   */
+  bool dequeue_wait(T &value, std::chrono::nanoseconds timeout =
+    std::chrono::nanoseconds::max()) {
+    return wait_for(not_empty_, timeout, [&]() { return dequeue(value); });
+  }
+
+  /**
+   * @brief This function returns a string debugging information
+   * @return the head, tail and capacity.
+   */
+  std::string debug_string() {
+    return "Head: " + std::to_string(head_.load()) + "\n"
+        + "Tail: " + std::to_string(tail_.load()) + "\n"
+        + "capacity_: " + std::to_string(capacity_) + "\n";
+  }
+
+ private:
+  /**
+   * Calls attempt until it succeeds, sleeping on event between attempts once
+   * TERVEL_RINGBUFFER_WAIT_SPIN attempts have failed.
+   * @return whether attempt succeeded before the timeout expired.
+   */
+  template<typename Attempt>
+  static bool wait_for(util::EventCount &event,
+      std::chrono::nanoseconds timeout, Attempt attempt) {
+    for (int i = 0; i < TERVEL_RINGBUFFER_WAIT_SPIN; i++) {
+      if (attempt()) {
+        return true;
+      }
+    }
+
+    const bool forever = (timeout == std::chrono::nanoseconds::max());
+    const auto deadline = std::chrono::steady_clock::now() +
+        (forever ? std::chrono::nanoseconds(0) : timeout);
+    while (true) {
+      uint32_t key = event.prepare_wait();
+      util::EventCount::waiter_barrier();
+      if (attempt()) {
+        event.cancel_wait();
+        return true;
+      }
+      std::chrono::nanoseconds remaining(-1);
+      if (!forever) {
+        remaining = deadline - std::chrono::steady_clock::now();
+        if (remaining.count() <= 0) {
+          event.cancel_wait();
+          return false;
+        }
+      }
+      event.wait(key, remaining);
+    }
+  }
+
+  const int64_t capacity_;
+  const int64_t capacity_mask_;
+  std::unique_ptr<T[]> array_;
+
+  // The fields above are read only, this keeps them off the counters' lines.
+  char padding_[CACHE_LINE_SIZE];
+  // The producer's line: the tail and the last value it read of the head.
+  std::atomic<int64_t> tail_ {0};
+  int64_t head_cache_ {0};
+  char padding2_[CACHE_LINE_SIZE - 2 * sizeof(int64_t)];
+  // The consumer's line: the head and the last value it read of the tail.
+  std::atomic<int64_t> head_ {0};
+  int64_t tail_cache_ {0};
+  char padding3_[CACHE_LINE_SIZE - 2 * sizeof(int64_t)];
+  // Threads in dequeue_wait wait on not_empty_, in enqueue_wait on not_full_.
+  util::EventCount not_empty_;
+  util::EventCount not_full_;
+
+  DISALLOW_COPY_AND_ASSIGN(RingBuffer);
+};  // class RingBuffer<T, buffer_role::SPSC>
+
+}  // namespace wf
+}  // namespace containers
+}  // namespace tervel
+
+#endif  // TERVEL_CONTAINERS_WF_RINGBUFFER_SPSC_RINGBUFFER_H_
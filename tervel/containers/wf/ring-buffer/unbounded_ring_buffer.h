@@ -0,0 +1,439 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef TERVEL_CONTAINERS_WF_RINGBUFFER_UNBOUNDED_RINGBUFFER_H_
+#define TERVEL_CONTAINERS_WF_RINGBUFFER_UNBOUNDED_RINGBUFFER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <assert.h>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include <tervel/util/info.h>
+#include <tervel/util/util.h>
+#include <tervel/util/padded_atomic.h>
+#include <tervel/util/progress_assurance.h>
+#include <tervel/util/system.h>
+#include <tervel/util/memory/hp/hp_element.h>
+#include <tervel/util/memory/hp/hazard_pointer.h>
+
+namespace tervel {
+namespace containers {
+namespace wf {
+
+/**
+ * @brief An unbounded FIFO buffer built from linked segments of positions,
+ * in the spirit of LCRQ, made wait-free with the progress assurance framework.
+ *
+ * @details The buffer behaves as an infinite array of positions. Producers
+ * take the index of a position from the tail counter and consumers from the
+ * head counter, both with a fetch-and-add, as in RingBuffer. The array is
+ * split into segments of segment_capacity positions which are linked in
+ * order: when an index falls past the last segment a new one is appended, so
+ * enqueue never fails.
+ *
+ * Unlike the positions of a RingBuffer a position is used only once, so it
+ * holds no seqid: it is empty until a value is placed in it and is then
+ * marked taken by its consumer. A consumer which finds its position empty
+ * marks it taken as well, and the producer of that index takes a new one.
+ *
+ * A thread watches the segment it starts from with a hazard pointer before
+ * taking an index, and the segments are freed in order, so that no segment
+ * after a watched one is freed. A segment is freed once both the head and
+ * the tail have moved past it and no thread watches it.
+ *
+ * An operation that fails to complete within the progress assurance limit
+ * is announced, and helpers complete it with Helper objects in the same way
+ * as in RingBuffer.
+ *
+ * @tparam T The type of information stored, either a pointer whose last two
+ * bits are 0 or an integral type of at most 32 bits.
+ */
+template<typename T>
+class UnboundedRingBuffer {
+  static const uintptr_t num_lsb = 3;
+  static const uintptr_t taken_lsb = 0x1;
+  static const uintptr_t oprec_lsb = 0x2;
+  static const uintptr_t packed_lsb = 0x4;
+  static const uintptr_t clear_lsb = 3;
+
+  // The contents of a position before a value is placed in it.
+  static const uintptr_t kEmpty = 0x0;
+  // The contents of a position after its value is dequeued, or after a
+  // consumer gave up waiting for its value.
+  static const uintptr_t kTaken = taken_lsb;
+
+  // Integral values are shifted past the reserved bits and marked with
+  // packed_lsb, so that a value of 0 is not an empty position.
+  static const bool kPacked = std::is_integral<T>::value;
+  typedef std::integral_constant<bool, kPacked> PackedType;
+
+  static_assert(sizeof(uintptr_t) == sizeof(uint64_t),
+    " Pointers muse be 64 bits");
+  static_assert(kPacked ? sizeof(T) <= sizeof(uint32_t) :
+    (std::is_pointer<T>::value && sizeof(T) == sizeof(uintptr_t)),
+    " T must be a pointer or an integral type of at most 32 bits");
+
+ public:
+  /**
+   * @brief Unbounded Ring Buffer constructor
+   *
+   * @param segment_capacity the number of positions of each segment, rounded
+   * up to a power of two so positions are computed with a mask.
+   */
+  explicit UnboundedRingBuffer(size_t segment_capacity = 1024);
+  ~UnboundedRingBuffer();
+
+  /**
+   * @return whether or not the buffer is empty.
+   */
+  bool isEmpty();
+
+  /**
+   * @brief Enqueues the passed value into the buffer
+   * @details This function takes an index from the tail counter and places
+   * value at its position, appending segments as needed.
+   *
+   * @param value The value to enqueue.
+   * @return true, the buffer can not be full.
+   */
+  bool enqueue(T value);
+
+  /**
+   * @brief Dequeues a value from the buffer
+   * @details This function attempts to dequeue a value.
+   * It returns false in the event the buffer is empty.
+   *
+   * @param value A variable to store the dequeued value.
+   * @return whether or not a value was dequeued.
+   */
+  bool dequeue(T &value);
+
+  /**
+   * @brief This function returns a string debugging information
+   * @return the head, tail, segment capacity and the live segments.
+   */
+  std::string debug_string();
+
+ private:
+  class Segment;
+  class BufferOp;
+  class EnqueueOp;
+  class DequeueOp;
+  class Helper;
+
+  /**
+   * @brief Watches the segment hint points to.
+   * @details The segment is watched in the SHORTUSE3 slot until
+   * unwatch_segment is called. While it is watched, neither it nor any
+   * segment after it is freed.
+   *
+   * @param hint head_seg_ or tail_seg_
+   * @return the watched segment.
+   */
+  Segment * watch_segment(util::PaddedAtomic<Segment *> &hint);
+  void unwatch_segment();
+
+  /**
+   * @brief Returns the position of index
+   * @details Follows the segments from seg to the one holding index,
+   * appending segments if it does not exist yet.
+   *
+   * @param seg a watched segment, or one after it, whose id is at most the
+   * id of the segment of index. It is set to the segment of index.
+   * @param index the index of the position.
+   * @return the position
+   */
+  std::atomic<uintptr_t> * getCell(Segment * &seg, int64_t index);
+
+  /**
+   * @brief Moves hint forward to seg, if it is behind it.
+   */
+  void advance(util::PaddedAtomic<Segment *> &hint, Segment *seg);
+
+  /**
+   * @brief Moves counter forward to value, if it is behind it.
+   * @details Used when a helper places or takes a value at a position the
+   * counter has not reached, as no fetch-and-add took its index.
+   */
+  void moveCounter(util::PaddedAtomic<int64_t> &counter, int64_t value);
+
+  /**
+   * @brief Frees the segments that are before both hints and not watched.
+   * @details Only one thread frees segments at a time, others return at
+   * once. Segments are freed in order and it stops at the first watched one.
+   */
+  void reclaim();
+
+  /**
+   * @brief This function attempts to load a value from a position
+   * @details If a Helper object is read it is resolved and the function
+   * returns false, so that the caller reads the position again.
+   *
+   * @param cell the position to load from
+   * @param val the variable to store the loaded value.
+   *
+   * @return whether or not a load was successful
+   */
+  bool readValue(std::atomic<uintptr_t> *cell, uintptr_t &val);
+
+  /**
+   * @brief Attempts to place val at cell
+   * @return whether or not val was placed, if not a new index is needed.
+   */
+  bool enqueueAt(std::atomic<uintptr_t> *cell, uintptr_t val);
+
+  /**
+   * @brief Attempts to take the value at cell, if there is none then the
+   * position is marked taken so that no value is placed in it later.
+   * @return whether or not a value was taken, if not a new index is needed.
+   */
+  bool dequeueAt(std::atomic<uintptr_t> *cell, T &value);
+
+  /**
+   * @brief A backoff routine, called when a position is still empty.
+   * @return whether or not the value at cell changed from val.
+   */
+  bool backoff(std::atomic<uintptr_t> *cell, uintptr_t val);
+
+  /**
+   * @brief Returns the contents of a position holding value.
+   */
+  static uintptr_t ValueType(T value);
+  static uintptr_t ValueType(T value, std::false_type);
+  static uintptr_t ValueType(T value, std::true_type);
+
+  /**
+   * @brief Returns the value held by a position, the inverse of ValueType.
+   */
+  static T getValueType(uintptr_t val);
+  static T getValueType(uintptr_t val, std::false_type);
+  static T getValueType(uintptr_t val, std::true_type);
+
+  const int64_t segment_capacity_;
+  const int64_t segment_mask_;
+  // log2(segment_capacity_), index >> segment_shift_ is the id of the segment
+  // of index.
+  const int64_t segment_shift_;
+
+  // The first segment not yet freed, only accessed by the thread that holds
+  // reclaiming_.
+  Segment *oldest_;
+  std::atomic<bool> reclaiming_ {false};
+
+  // The fields above are rarely written, this keeps them off the counters'
+  // lines.
+  char padding_[CACHE_LINE_SIZE];
+  // Producers update tail_ and consumers head_, each on its own cache line.
+  util::PaddedAtomic<int64_t> head_ {0};
+  util::PaddedAtomic<int64_t> tail_ {0};
+  // The segments the last indices taken from head_ and tail_ belong to, or
+  // segments before them. Operations start looking for their position here.
+  util::PaddedAtomic<Segment *> head_seg_;
+  util::PaddedAtomic<Segment *> tail_seg_;
+
+  DISALLOW_COPY_AND_ASSIGN(UnboundedRingBuffer);
+};  // class UnboundedRingBuffer
+
+
+/**
+ * @brief A segment of the positions of the buffer.
+ * @details The segment with id i holds the positions of the indices
+ * i * segment_capacity_ through (i + 1) * segment_capacity_ - 1.
+ */
+template<typename T>
+class UnboundedRingBuffer<T>::Segment {
+ public:
+  Segment(int64_t id, int64_t capacity)
+    : id_(id)
+    , cells_(new std::atomic<uintptr_t>[capacity]) {
+    for (int64_t i = 0; i < capacity; i++) {
+      cells_[i].store(kEmpty, std::memory_order_relaxed);
+    }
+  }
+
+  const int64_t id_;
+  std::unique_ptr<std::atomic<uintptr_t>[]> cells_;
+  std::atomic<Segment *> next_ {nullptr};
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(Segment);
+};
+
+
+/**
+ * @brief The base of the operations announced by the buffer.
+ * @details An operation is complete once a Helper is associated with it, or
+ * it is failed. The first Helper associated decides where it took effect.
+ */
+template<typename T>
+class UnboundedRingBuffer<T>::BufferOp : public util::OpRecord {
+ public:
+  explicit BufferOp(UnboundedRingBuffer<T> *rb)
+    : rb_(rb) {}
+
+  ~BufferOp() {
+    Helper *h = helper_.load();
+    if (h != nullptr && h != fail_val_) {
+      delete h;
+    }
+  }
+
+  virtual void * associate(Helper *h) = 0;
+
+  /**
+   * @return whether or not h is the associated Helper, which it also is if
+   * another thread resolving h associated it first.
+   */
+  bool privAssociate(Helper *h) {
+    Helper *temp = nullptr;
+    return helper_.compare_exchange_strong(temp, h) || temp == h;
+  }
+
+  bool valid(Helper * h) {
+    return helper_.load() == h;
+  }
+
+  void fail() {
+    Helper *temp = nullptr;
+    helper_.compare_exchange_strong(temp, fail_val_);
+  }
+
+  bool isFail(Helper * &h) {
+    return (h = helper_.load()) == fail_val_;
+  }
+
+  bool notDone() {
+    return helper_.load() == nullptr;
+  }
+
+  /**
+   * The associated Helper is freed with the op, so the op is not freed while
+   * a thread that read the Helper from a position watches it.
+   */
+  bool on_is_watched() {
+    Helper *h = helper_.load();
+    return h != nullptr && h != fail_val_ &&
+        tervel::util::memory::hp::HazardPointer::is_watched(h);
+  }
+
+  static Helper * const fail_val_;
+
+  UnboundedRingBuffer<T> * const rb_;
+  std::atomic<Helper *> helper_ {nullptr};
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(BufferOp);
+};
+
+template<typename T>
+typename UnboundedRingBuffer<T>::Helper * const
+UnboundedRingBuffer<T>::BufferOp::fail_val_ =
+    reinterpret_cast<typename UnboundedRingBuffer<T>::Helper *>(0x1L);
+
+
+/**
+ * @brief Placed in a position by a thread helping an operation.
+ * @details A thread that reads it associates it with its operation, if no
+ * other Helper has been, and replaces it with the contents that result: the
+ * operation's effect if it was associated, otherwise old_value_.
+ */
+template<typename T>
+class UnboundedRingBuffer<T>::Helper
+    : public tervel::util::memory::hp::Element {
+ public:
+  Helper(BufferOp *op, uintptr_t old_value, int64_t index)
+   : op_(op)
+   , old_value_(old_value)
+   , index_(index) {}
+
+  bool on_watch(std::atomic<void *> *address, void *expected);
+
+  bool valid() {
+    return op_->valid(this);
+  }
+
+  static uintptr_t HelperType(Helper *h) {
+    return reinterpret_cast<uintptr_t>(h) | oprec_lsb;
+  }
+
+  static bool isHelperType(uintptr_t val) {
+    return (val & oprec_lsb) != 0;
+  }
+
+  static Helper * getHelperType(uintptr_t val) {
+    return reinterpret_cast<Helper *>(val & ~oprec_lsb);
+  }
+
+  BufferOp * const op_;
+  const uintptr_t old_value_;
+  // The index of the position the Helper was placed at.
+  const int64_t index_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(Helper);
+};
+
+
+template<typename T>
+class UnboundedRingBuffer<T>::EnqueueOp : public BufferOp {
+ public:
+  EnqueueOp(UnboundedRingBuffer<T> *rb, uintptr_t value)
+    : BufferOp(rb)
+    , value_(value) {}
+
+  void * associate(Helper *h);
+  void help_complete();
+
+ private:
+  // The contents of the position the value is placed at.
+  const uintptr_t value_;
+  DISALLOW_COPY_AND_ASSIGN(EnqueueOp);
+};
+
+
+template<typename T>
+class UnboundedRingBuffer<T>::DequeueOp : public BufferOp {
+ public:
+  explicit DequeueOp(UnboundedRingBuffer<T> *rb)
+    : BufferOp(rb) {}
+
+  void * associate(Helper *h);
+  void help_complete();
+  bool result(T &value);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(DequeueOp);
+};
+
+}  // namespace wf
+}  // namespace containers
+}  // namespace tervel
+
+#include <tervel/containers/wf/ring-buffer/unbounded_ring_buffer_imp.h>
+
+#endif  // TERVEL_CONTAINERS_WF_RINGBUFFER_UNBOUNDED_RINGBUFFER_H_
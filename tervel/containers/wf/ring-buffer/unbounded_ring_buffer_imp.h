@@ -0,0 +1,517 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef TERVEL_CONTAINERS_WF_RINGBUFFER_UNBOUNDED_RINGBUFFER_IMP_H_
+#define TERVEL_CONTAINERS_WF_RINGBUFFER_UNBOUNDED_RINGBUFFER_IMP_H_
+
+namespace tervel {
+namespace containers {
+namespace wf {
+
+template<typename T>
+UnboundedRingBuffer<T>::
+UnboundedRingBuffer(size_t segment_capacity)
+  : segment_capacity_(int64_t(1) <<
+      util::round_to_next_power_of_two(segment_capacity))
+  , segment_mask_(segment_capacity_ - 1)
+  , segment_shift_(util::round_to_next_power_of_two(segment_capacity_))
+  , oldest_(new Segment(0, segment_capacity_)) {
+  assert(segment_capacity > 0);
+  head_seg_.store(oldest_);
+  tail_seg_.store(oldest_);
+}
+
+template<typename T>
+UnboundedRingBuffer<T>::
+~UnboundedRingBuffer() {
+  Segment *seg = oldest_;
+  while (seg != nullptr) {
+    Segment *next = seg->next_.load();
+    delete seg;
+    seg = next;
+  }
+}
+
+template<typename T>
+bool UnboundedRingBuffer<T>::
+isEmpty() {
+  return head_.load() >= tail_.load();
+}
+
+template<typename T>
+bool UnboundedRingBuffer<T>::
+enqueue(T value) {
+  tervel::util::ProgressAssurance::check_for_announcement();
+  const uintptr_t val = ValueType(value);
+
+  util::ProgressAssurance::Limit progAssur;
+  while (progAssur.notDelayed()) {
+    Segment *seg = watch_segment(tail_seg_);
+    int64_t index = tail_.fetch_add(1);
+    std::atomic<uintptr_t> *cell = getCell(seg, index);
+    advance(tail_seg_, seg);
+
+    bool res = enqueueAt(cell, val);
+    unwatch_segment();
+    if ((index & segment_mask_) == 0) {
+      reclaim();
+    }
+    if (res) {
+      return true;
+    }
+  }
+
+  EnqueueOp *op = new EnqueueOp(this, val);
+  tervel::util::ProgressAssurance::make_announcement(op);
+  op->safe_delete();
+  return true;
+}
+
+template<typename T>
+bool UnboundedRingBuffer<T>::
+enqueueAt(std::atomic<uintptr_t> *cell, uintptr_t val) {
+  uintptr_t temp;
+  while (true) {
+    if (!readValue(cell, temp)) {
+      continue;
+    }
+    if (temp != kEmpty) {
+      // A consumer gave up on the position, or a helper used it.
+      return false;
+    }
+    if (cell->compare_exchange_strong(temp, val)) {
+      return true;
+    }
+  }
+}
+
+template<typename T>
+bool UnboundedRingBuffer<T>::
+dequeue(T &value) {
+  tervel::util::ProgressAssurance::check_for_announcement();
+
+  util::ProgressAssurance::Limit progAssur;
+  while (progAssur.notDelayed()) {
+    if (isEmpty()) {
+      return false;
+    }
+
+    Segment *seg = watch_segment(head_seg_);
+    int64_t index = head_.fetch_add(1);
+    std::atomic<uintptr_t> *cell = getCell(seg, index);
+    advance(head_seg_, seg);
+
+    bool res = dequeueAt(cell, value);
+    unwatch_segment();
+    if ((index & segment_mask_) == 0) {
+      reclaim();
+    }
+    if (res) {
+      return true;
+    }
+  }
+
+  DequeueOp *op = new DequeueOp(this);
+  tervel::util::ProgressAssurance::make_announcement(op);
+  bool res = op->result(value);
+  op->safe_delete();
+  return res;
+}
+
+template<typename T>
+bool UnboundedRingBuffer<T>::
+dequeueAt(std::atomic<uintptr_t> *cell, T &value) {
+  uintptr_t val;
+  while (true) {
+    if (!readValue(cell, val)) {
+      continue;
+    }
+    if (val == kTaken) {
+      // A helper took the value.
+      return false;
+    } else if (val == kEmpty) {
+      if (backoff(cell, val)) {
+        // The value arrived.
+        continue;
+      }
+      // The producer is lagging, so ensure it does not place its value here,
+      // where no consumer would find it, and take a new index.
+      if (cell->compare_exchange_strong(val, kTaken)) {
+        return false;
+      }
+      continue;
+    } else {
+      if (cell->compare_exchange_strong(val, kTaken)) {
+        value = getValueType(val);
+        return true;
+      }
+      continue;
+    }
+  }
+}
+
+template<typename T>
+typename UnboundedRingBuffer<T>::Segment *
+UnboundedRingBuffer<T>::
+watch_segment(util::PaddedAtomic<Segment *> &hint) {
+  typedef tervel::util::memory::hp::HazardPointer::SlotID SlotID;
+  std::atomic<void *> *address =
+      reinterpret_cast<std::atomic<void *> *>(&(hint.atomic));
+  Segment *seg = hint.load();
+  while (!tervel::util::memory::hp::HazardPointer::watch(SlotID::SHORTUSE3,
+        reinterpret_cast<void *>(seg), address, reinterpret_cast<void *>(seg))) {
+    seg = hint.load();
+  }
+  return seg;
+}
+
+template<typename T>
+void UnboundedRingBuffer<T>::
+unwatch_segment() {
+  typedef tervel::util::memory::hp::HazardPointer::SlotID SlotID;
+  tervel::util::memory::hp::HazardPointer::unwatch(SlotID::SHORTUSE3);
+}
+
+template<typename T>
+std::atomic<uintptr_t> *
+UnboundedRingBuffer<T>::
+getCell(Segment * &seg, int64_t index) {
+  const int64_t id = index >> segment_shift_;
+  assert(seg->id_ <= id && "The hint moved past an index not yet taken");
+  while (seg->id_ < id) {
+    Segment *next = seg->next_.load();
+    if (next == nullptr) {
+      Segment *temp = new Segment(seg->id_ + 1, segment_capacity_);
+      if (seg->next_.compare_exchange_strong(next, temp)) {
+        next = temp;
+      } else {
+        delete temp;
+      }
+    }
+    seg = next;
+  }
+  return &(seg->cells_[index & segment_mask_]);
+}
+
+template<typename T>
+void UnboundedRingBuffer<T>::
+advance(util::PaddedAtomic<Segment *> &hint, Segment *seg) {
+  // The hint is at or after the watched segment, so it has not been freed.
+  Segment *temp = hint.load();
+  while (temp->id_ < seg->id_) {
+    if (hint.compare_exchange_weak(temp, seg)) {
+      break;
+    }
+  }
+}
+
+template<typename T>
+void UnboundedRingBuffer<T>::
+moveCounter(util::PaddedAtomic<int64_t> &counter, int64_t value) {
+  int64_t temp = counter.load();
+  while (temp < value) {
+    if (counter.compare_exchange_strong(temp, value)) {
+      break;
+    }
+  }
+}
+
+template<typename T>
+void UnboundedRingBuffer<T>::
+reclaim() {
+  #ifdef TERVEL_MEM_HP_NO_FREE
+    return;
+  #endif
+  bool expected = false;
+  if (reclaiming_.load() ||
+        !reclaiming_.compare_exchange_strong(expected, true)) {
+    return;
+  }
+
+  // Only this thread frees segments, so the hints can be read safely.
+  const int64_t limit = std::min(head_seg_.load()->id_,
+        tail_seg_.load()->id_);
+  while (oldest_->id_ < limit &&
+        !tervel::util::memory::hp::HazardPointer::is_watched(
+          reinterpret_cast<void *>(oldest_))) {
+    Segment *next = oldest_->next_.load();
+    delete oldest_;
+    oldest_ = next;
+  }
+
+  reclaiming_.store(false);
+}
+
+template<typename T>
+bool UnboundedRingBuffer<T>::
+readValue(std::atomic<uintptr_t> *cell, uintptr_t &val) {
+  val = cell->load();
+  if (Helper::isHelperType(val)) {
+    Helper *h = Helper::getHelperType(val);
+    std::atomic<void *> *address = reinterpret_cast<std::atomic<void *> *>(cell);
+    typedef tervel::util::memory::hp::HazardPointer::SlotID SlotID;
+    bool res = tervel::util::memory::hp::HazardPointer::watch(
+        SlotID::SHORTUSE, h, address, reinterpret_cast<void *>(val));
+    assert(!res);
+    (void)res;
+    return false;
+  } else {
+    return true;
+  }
+}
+
+template<typename T>
+bool UnboundedRingBuffer<T>::
+backoff(std::atomic<uintptr_t> *cell, uintptr_t val) {
+  tervel::util::backoff();
+  return cell->load() != val;
+}
+
+template<typename T>
+uintptr_t UnboundedRingBuffer<T>::
+ValueType(T value) {
+  return ValueType(value, PackedType());
+}
+
+template<typename T>
+uintptr_t UnboundedRingBuffer<T>::
+ValueType(T value, std::false_type) {
+  uintptr_t temp = reinterpret_cast<uintptr_t>(value);
+  assert(temp != kEmpty && "Null can not be enqueued");
+  assert((temp & clear_lsb) == 0 && " reserved bits are not 0?");
+  return temp;
+}
+
+template<typename T>
+uintptr_t UnboundedRingBuffer<T>::
+ValueType(T value, std::true_type) {
+  uintptr_t temp = static_cast<uintptr_t>(static_cast<uint32_t>(value));
+  return (temp << num_lsb) | packed_lsb;
+}
+
+template<typename T>
+T UnboundedRingBuffer<T>::
+getValueType(uintptr_t val) {
+  return getValueType(val, PackedType());
+}
+
+template<typename T>
+T UnboundedRingBuffer<T>::
+getValueType(uintptr_t val, std::false_type) {
+  return reinterpret_cast<T>(val);
+}
+
+template<typename T>
+T UnboundedRingBuffer<T>::
+getValueType(uintptr_t val, std::true_type) {
+  return static_cast<T>(static_cast<uint32_t>(val >> num_lsb));
+}
+
+template<typename T>
+std::string UnboundedRingBuffer<T>::
+debug_string() {
+  return "Head: " + std::to_string(head_.load()) + "\n"
+      + "Tail: " + std::to_string(tail_.load()) + "\n"
+      + "segment_capacity_: " + std::to_string(segment_capacity_) + "\n"
+      + "Head segment: " + std::to_string(head_seg_.load()->id_) + "\n"
+      + "Tail segment: " + std::to_string(tail_seg_.load()->id_) + "\n";
+}
+
+
+template<typename T>
+bool UnboundedRingBuffer<T>::Helper::
+on_watch(std::atomic<void *> *address, void *expected) {
+  typedef tervel::util::memory::hp::HazardPointer::SlotID SlotID;
+  SlotID pos = SlotID::SHORTUSE2;
+  bool res = tervel::util::memory::hp::HazardPointer::watch(pos, op_,
+      address, expected);
+  if (!res) {
+    return false;
+  }
+
+  void *val = op_->associate(this);
+  address->compare_exchange_strong(expected, val);
+  tervel::util::memory::hp::HazardPointer::unwatch(pos);
+
+  return false;
+}
+
+
+template<typename T>
+void UnboundedRingBuffer<T>::EnqueueOp::
+help_complete() {
+  UnboundedRingBuffer<T> *rb = this->rb_;
+  Segment *seg = rb->watch_segment(rb->tail_seg_);
+  const int64_t first_id = seg->id_;
+  int64_t tail = rb->tail_.load();
+
+  while (this->notDone()) {
+    int64_t index = tail++;
+    std::atomic<uintptr_t> *cell = rb->getCell(seg, index);
+    uintptr_t val;
+
+    while (this->notDone()) {
+      if (!rb->readValue(cell, val)) {
+        continue;
+      }
+      if (val != kEmpty) {
+        // It holds a value or was given up on, try the next position.
+        break;
+      }
+
+      Helper *helper = new Helper(this, val, index);
+      uintptr_t helper_int = Helper::HelperType(helper);
+      if (cell->compare_exchange_strong(val, helper_int)) {
+        // Associates the helper and replaces it, as a watch of it would.
+        helper->on_watch(reinterpret_cast<std::atomic<void *> *>(cell),
+            reinterpret_cast<void *>(helper_int));
+        if (helper->valid()) {
+          // The thread that associated it may not have moved the tail counter
+          // yet, and the hint must not pass it.
+          rb->moveCounter(rb->tail_, index + 1);
+          rb->advance(rb->tail_seg_, seg);
+        } else {
+          helper->safe_delete();
+        }
+        break;  // Op is Done!
+      } else {
+        delete helper;
+      }
+    }
+  }
+
+  const bool crossed = seg->id_ != first_id;
+  rb->unwatch_segment();
+  if (crossed) {
+    rb->reclaim();
+  }
+}
+
+template<typename T>
+void * UnboundedRingBuffer<T>::EnqueueOp::
+associate(Helper *h) {
+  uintptr_t new_val = h->old_value_;
+  if (BufferOp::privAssociate(h)) {
+    new_val = value_;
+  }
+  // Ensure the tail counter covers the position, otherwise it could be
+  // reported empty.
+  this->rb_->moveCounter(this->rb_->tail_, this->helper_.load()->index_ + 1);
+  return reinterpret_cast<void *>(new_val);
+}
+
+
+template<typename T>
+void UnboundedRingBuffer<T>::DequeueOp::
+help_complete() {
+  UnboundedRingBuffer<T> *rb = this->rb_;
+  Segment *seg = rb->watch_segment(rb->head_seg_);
+  const int64_t first_id = seg->id_;
+  int64_t head = rb->head_.load();
+
+  while (this->notDone()) {
+    if (head >= rb->tail_.load()) {
+      this->fail();
+      // Every position before head was found taken, so move the head counter
+      // past them, otherwise isEmpty would keep reporting them.
+      rb->moveCounter(rb->head_, head);
+      rb->advance(rb->head_seg_, seg);
+      break;
+    }
+    int64_t index = head++;
+    std::atomic<uintptr_t> *cell = rb->getCell(seg, index);
+    uintptr_t val;
+
+    while (this->notDone()) {
+      if (!rb->readValue(cell, val)) {
+        continue;
+      }
+      if (val == kTaken) {
+        break;
+      } else if (val == kEmpty) {
+        // Ensure no value is placed here once a later one has been taken,
+        // which keeps FIFO.
+        cell->compare_exchange_strong(val, kTaken);
+        continue;
+      }
+
+      Helper *helper = new Helper(this, val, index);
+      uintptr_t helper_int = Helper::HelperType(helper);
+      if (cell->compare_exchange_strong(val, helper_int)) {
+        helper->on_watch(reinterpret_cast<std::atomic<void *> *>(cell),
+            reinterpret_cast<void *>(helper_int));
+        if (helper->valid()) {
+          // The thread that associated it may not have moved the head counter
+          // yet, and the hint must not pass it.
+          rb->moveCounter(rb->head_, index + 1);
+          rb->advance(rb->head_seg_, seg);
+        } else {
+          helper->safe_delete();
+        }
+        break;  // Op is Done!
+      } else {
+        delete helper;
+      }
+    }
+  }
+
+  const bool crossed = seg->id_ != first_id;
+  rb->unwatch_segment();
+  if (crossed) {
+    rb->reclaim();
+  }
+}
+
+template<typename T>
+void * UnboundedRingBuffer<T>::DequeueOp::
+associate(Helper *h) {
+  uintptr_t new_val = h->old_value_;
+  if (BufferOp::privAssociate(h)) {
+    new_val = kTaken;
+  }
+  // Move the head counter past the position, so that consumers do not
+  // examine positions before it.
+  Helper *temp_h = this->helper_.load();
+  if (temp_h != BufferOp::fail_val_) {
+    this->rb_->moveCounter(this->rb_->head_, temp_h->index_ + 1);
+  }
+  return reinterpret_cast<void *>(new_val);
+}
+
+template<typename T>
+bool UnboundedRingBuffer<T>::DequeueOp::
+result(T &value) {
+  Helper *h;
+  if (BufferOp::isFail(h)) {
+    return false;
+  }
+  value = getValueType(h->old_value_);
+  return true;
+}
+
+}  // namespace wf
+}  // namespace containers
+}  // namespace tervel
+
+#endif  // TERVEL_CONTAINERS_WF_RINGBUFFER_UNBOUNDED_RINGBUFFER_IMP_H_
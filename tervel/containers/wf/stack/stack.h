@@ -35,6 +35,7 @@ THE SOFTWARE.
 
 #include <tervel/util/info.h>
 #include <tervel/util/util.h>
+#include <tervel/util/elimination_array.h>
 #include <tervel/util/progress_assurance.h>
 #include <tervel/util/memory/hp/hp_element.h>
 #include <tervel/util/memory/hp/hazard_pointer.h>
@@ -65,6 +66,10 @@ class Stack {
   DISALLOW_COPY_AND_ASSIGN(Stack);
  private:
   std::atomic<Node *> lst_ __attribute__((aligned(CACHE_LINE_SIZE)));
+#ifdef TERVEL_STACK_ELIMINATION
+  // Pairs a push and a pop which fail to update lst_ at the same time.
+  util::EliminationArray<T> elimination_;
+#endif
 }; // class Stack
 
 
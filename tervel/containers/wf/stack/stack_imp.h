@@ -75,6 +75,13 @@ bool Stack<T>::push(T v) {
     if (lst_.compare_exchange_strong(cur, elem)) {
       return true;
     }
+#ifdef TERVEL_STACK_ELIMINATION
+    // elem was never reachable from lst_, so it is freed directly.
+    if (elimination_.offer(v)) {
+      delete elem;
+      return true;
+    }
+#endif
   } // while (true)
 
   // If isDelayed() returns true, we add our operation to the announcement table.
@@ -116,6 +123,11 @@ bool Stack<T>::pop(T& v) {
       cur->safe_delete();
       return true;
     }
+#ifdef TERVEL_STACK_ELIMINATION
+    else if (elimination_.take(v)) {
+      return true;
+    }
+#endif
   } // while (true)
 
   PopOp *op = new PopOp(this);
@@ -108,7 +108,7 @@ class Stack<T>::StackOp : public util::OpRecord {
     return false;
   }
 
-  static constexpr Helper * fail_val_ = reinterpret_cast<Helper *>(0x1L);
+  static Helper * const fail_val_;
 
   Stack<T> * stack_;
   std::atomic<Helper *> helper_{nullptr};
@@ -116,6 +116,10 @@ class Stack<T>::StackOp : public util::OpRecord {
 
 };  // class StackOp<T>::StackOp
 
+template<typename T>
+typename Stack<T>::Helper * const Stack<T>::StackOp::fail_val_ =
+    reinterpret_cast<typename Stack<T>::Helper *>(0x1L);
+
 /**
   * This defines the PopOp class. This class is used to 
   * guide an arbitrary thread to complete a pending pop operation.
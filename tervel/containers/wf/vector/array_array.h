@@ -25,7 +25,14 @@ THE SOFTWARE.
 #ifndef __TERVEL_CONTAINERS_WF_VECTOR_VECTOR_ARRAY_ARRAY_H
 #define __TERVEL_CONTAINERS_WF_VECTOR_VECTOR_ARRAY_ARRAY_H
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
 #include <tervel/util/util.h>
+#include <tervel/util/event_count.h>
 
 #include <tervel/containers/wf/vector/vector_array.h>
 
@@ -58,15 +65,22 @@ class ArrayArray : public VectorArray<T> {
       array_of_arrays_[i].store(nullptr);
     }
     offset_pow_ = tervel::util::round_to_next_power_of_two(capacity);
-    offset_ = std::pow(2, offset_pow_);
+    offset_ = size_t(1) << offset_pow_;
 
     array_of_arrays_[0].store(allocate_array_segment(offset_));
     current_capacity_.store(offset_);
   }
 
   ~ArrayArray() {
+    stop_pregrow();
     for (size_t i = 0; i < k_max_array_segments_; i++) {
-      delete [] array_of_arrays_[i];
+      // The segments past the last one allocated are null, and the length of
+      // the later ones does not fit in a size_t.
+      ArraySegment seg = array_of_arrays_[i].load();
+      if (seg != nullptr) {
+        this->free_elements(seg, segment_capacity(i, offset_pow_),
+            default_value_);
+      }
     }
   }
 
@@ -80,14 +94,14 @@ class ArrayArray : public VectorArray<T> {
     ArraySegment cur_seg = array_of_arrays_[pos].load();
 
     if (cur_seg == nullptr) {
-      size_t seg_cap = 0x1 << (offset_pow_ + pos);
+      size_t seg_cap = segment_capacity(pos, offset_pow_);
       ArraySegment new_seg = allocate_array_segment(seg_cap);
 
       if (array_of_arrays_[pos].compare_exchange_strong(cur_seg, new_seg)) {
         current_capacity_.fetch_add(seg_cap);
         return new_seg;
       } else {
-        delete [] new_seg;
+        this->free_elements(new_seg, seg_cap, default_value_);
         return cur_seg;
       }
     }  // if cur_seg == nullprt
@@ -103,15 +117,19 @@ class ArrayArray : public VectorArray<T> {
    */
   ArrayElement * get_spot(const size_t raw_pos, const bool no_add = false) {
     if (raw_pos < offset_) {
+      if (pregrow_.load(std::memory_order_relaxed) &&
+            raw_pos >= (offset_ >> 1)) {
+        request_segment(1);
+      }
       ArraySegment seg = array_of_arrays_[0].load();
       return &(seg[raw_pos]);
     } else {
-      static const int nobits = (sizeof(unsigned int) << 3) - 1;
-      size_t pos = raw_pos + offset_;
-      size_t num = nobits - __builtin_clz(pos);
-
-      size_t elem_pos = pos ^ (1 << num);
-      size_t seg_num = num - offset_pow_;
+      size_t seg_num, elem_pos;
+      locate(raw_pos, offset_pow_, seg_num, elem_pos);
+      if (pregrow_.load(std::memory_order_relaxed) &&
+            elem_pos >= (segment_capacity(seg_num, offset_pow_) >> 1)) {
+        request_segment(seg_num + 1);
+      }
 
       ArraySegment seg = array_of_arrays_[seg_num].load();
       if (seg == nullptr && !no_add) {
@@ -127,26 +145,198 @@ class ArrayArray : public VectorArray<T> {
     }  // else it is first array
   }  // get_pos
 
+  /**
+   * Returns the address of raw_pos and the number of positions that follow
+   * it in the same segment, so that a range of positions can be written with
+   * plain stores.
+   *
+   * @param raw_pos the position
+   * @param length set to the number of positions from raw_pos to the end of
+   * its segment
+   * @param no_add if true then a missing segment is not allocated and nullptr
+   * is returned
+   * @return the address of the specified position
+   */
+  ArrayElement * get_chunk(const size_t raw_pos, size_t &length,
+      const bool no_add = false) {
+    size_t seg_num, elem_pos;
+    locate(raw_pos, offset_pow_, seg_num, elem_pos);
+    length = segment_capacity(seg_num, offset_pow_) - elem_pos;
+    return get_spot(raw_pos, no_add);
+  }
+
+  /**
+   * Computes where a position is stored. Segment 0 holds the first
+   * 2^offset_pow positions and each following segment twice as many as the
+   * one before it, so raw_pos + 2^offset_pow has its highest bit at
+   * offset_pow + seg_num and the bits below it are the position in the
+   * segment. The sum must not overflow, so raw_pos must be less than
+   * 2^64 - 2^offset_pow, and every such position maps to one of the
+   * k_max_array_segments_ segments.
+   *
+   * @param raw_pos the position
+   * @param offset_pow log2 of the length of the first segment
+   * @param seg_num set to the segment holding raw_pos
+   * @param elem_pos set to the position of raw_pos in the segment
+   */
+  static void locate(const size_t raw_pos, const size_t offset_pow,
+      size_t &seg_num, size_t &elem_pos) {
+    static const int nobits = (sizeof(unsigned long long) << 3) - 1;
+    assert(raw_pos < ~size_t(0) - (size_t(1) << offset_pow) + 1);
+    const size_t pos = raw_pos + (size_t(1) << offset_pow);
+    const size_t num = nobits - __builtin_clzll(pos);
+
+    elem_pos = pos ^ (size_t(1) << num);
+    seg_num = num - offset_pow;
+    assert(seg_num < k_max_array_segments_);
+  }
+
+  /**
+   * @param seg_num a segment
+   * @param offset_pow log2 of the length of the first segment
+   * @return the number of positions in the segment
+   */
+  static size_t segment_capacity(const size_t seg_num,
+      const size_t offset_pow) {
+    return size_t(1) << (offset_pow + seg_num);
+  }
+
   ArrayElement *allocate_array_segment(const size_t capacity) {
-    ArrayElement * temp = new ArrayElement[capacity];
-    for (uint64_t i = 0; i < capacity; i++) {
-      temp[i] = default_value_;
-    }
-    return temp;
+    return this->allocate_elements(capacity, default_value_);
   }
 
   size_t capacity() {
     return current_capacity_.load();
   }
 
+  /**
+   * Allocates the segments holding the first n positions which have not been
+   * allocated yet.
+   *
+   * @param n the number of positions
+   * @param num_workers the number of threads to allocate the segments with,
+   * each allocates whole segments, largest first.
+   */
+  void reserve(const size_t n, const size_t num_workers = 1) {
+    if (n <= offset_) {
+      return;
+    }
+    size_t last_seg, elem_pos;
+    locate(n - 1, offset_pow_, last_seg, elem_pos);
+
+    if (num_workers <= 1) {
+      for (size_t i = 1; i <= last_seg; i++) {
+        add_segment(i);
+      }
+      return;
+    }
+
+    std::atomic<int64_t> next(last_seg);
+    std::vector<std::thread> workers;
+    for (size_t w = 0; w < std::min(num_workers, last_seg); w++) {
+      workers.emplace_back([this, &next]() {
+        int64_t seg;
+        while ((seg = next.fetch_sub(1)) > 0) {
+          add_segment(seg);
+        }
+      });
+    }
+    for (size_t w = 0; w < workers.size(); w++) {
+      workers[w].join();
+    }
+  }
+
+  /**
+   * Starts a thread which allocates the segment after the last one in use
+   * once that one is half full, so that get_spot does not allocate unless
+   * positions are used faster than the thread allocates them. The thread is
+   * stopped when the array is destroyed.
+   */
+  void start_pregrow() {
+    bool expected = false;
+    if (pregrow_.compare_exchange_strong(expected, true)) {
+      pregrow_thread_ = std::thread(&ArrayArray::pregrow_loop, this);
+    }
+  }
+
+  /**
+   * The array grows as it is used, so there is always room for n more values.
+   */
+  bool claim_positions(const size_t n) {
+    (void)n;
+    return true;
+  }
+
+  void release_positions(const size_t n) {
+    (void)n;
+  }
+
+  /**
+   * Stops the thread started by start_pregrow, if there is one.
+   */
+  void stop_pregrow() {
+    if (pregrow_.load()) {
+      pregrow_stop_.store(true);
+      grow_event_.notify();
+      pregrow_thread_.join();
+      pregrow_.store(false);
+      pregrow_stop_.store(false);
+    }
+  }
+
  private:
+  /**
+   * Asks the pregrow thread to allocate the specified segment, if it is not
+   * allocated. Requests only ever increase.
+   */
+  void request_segment(const size_t seg_num) {
+    if (seg_num >= k_max_array_segments_ ||
+          array_of_arrays_[seg_num].load(std::memory_order_relaxed)
+          != nullptr) {
+      return;
+    }
+    size_t cur = grow_request_.load();
+    while (cur < seg_num) {
+      if (grow_request_.compare_exchange_weak(cur, seg_num)) {
+        grow_event_.notify();
+        return;
+      }
+    }
+  }
+
+  void pregrow_loop() {
+    while (true) {
+      uint32_t key = grow_event_.prepare_wait();
+      if (pregrow_stop_.load()) {
+        grow_event_.cancel_wait();
+        return;
+      }
+      size_t seg_num = grow_request_.load();
+      if (array_of_arrays_[seg_num].load() == nullptr) {
+        grow_event_.cancel_wait();
+        add_segment(seg_num);
+        continue;
+      }
+      grow_event_.wait(key, std::chrono::nanoseconds(-1));
+    }
+  }
+
   const T default_value_;
+  // The first segment holds at least 2 positions, so at most 63 segments
+  // are needed to cover every position locate accepts.
   static const size_t k_max_array_segments_ {64};
 
   std::atomic<ArraySegment> array_of_arrays_[k_max_array_segments_];
   size_t offset_, offset_pow_;
 
   std::atomic<size_t> current_capacity_;
+
+  // State used by start_pregrow.
+  std::atomic<bool> pregrow_ {false};
+  std::atomic<bool> pregrow_stop_ {false};
+  std::atomic<size_t> grow_request_ {0};
+  util::EventCount grow_event_;
+  std::thread pregrow_thread_;
 };  // class Vector Array
 }  // namespace vector
 }  // namespace wf
@@ -39,7 +39,8 @@ namespace vector {
 
 
 template<typename T>
-bool VectorArray<T>::shift_is_descriptor(T &expected, std::atomic<T> *spot, void *op ) {
+bool VectorArray<T>::shift_is_descriptor(T &expected,
+    std::atomic<T> *spot, void *op) {
   void *ptr = reinterpret_cast<void *>(expected);
   std::atomic<void *> *address = reinterpret_cast<std::atomic<void *> *>(spot);
   if (util::memory::rc::is_descriptor_first(ptr) == false) {
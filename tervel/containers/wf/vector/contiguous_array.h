@@ -0,0 +1,165 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef __TERVEL_CONTAINERS_WF_VECTOR_CONTIGUOUS_ARRAY_H
+#define __TERVEL_CONTAINERS_WF_VECTOR_CONTIGUOUS_ARRAY_H
+
+#include <assert.h>
+#include <atomic>
+
+#include <tervel/util/util.h>
+#include <tervel/util/padded_atomic.h>
+
+#include <tervel/containers/wf/vector/vector_array.h>
+
+namespace tervel {
+namespace containers {
+namespace wf {
+namespace vector {
+
+/**
+ * @brief Stores the vector's elements in a single array which is allocated
+ * when the vector is constructed.
+ *
+ * @details A position is an index into the array, so no segment table is
+ * read and a range of positions is one chunk. The array never grows: the
+ * capacity passed to the constructor is the most values the vector holds,
+ * and a push or insert which would exceed it fails. The operations also use
+ * the positions after the values, a pop places its descriptor after the last
+ * value and an insert covers as many positions after it as it inserts
+ * values, so the array has a second capacity's worth of positions which
+ * never hold a value. As the array is mapped from zero filled pages, a large
+ * capacity only costs memory once it is used.
+ * It is used by Vector when TERVEL_VECTOR_CONTIGUOUS is defined.
+ *
+ * @tparam T the type of the elements
+ */
+template<typename T>
+class ContiguousArray : public VectorArray<T> {
+  typedef std::atomic<T> ArrayElement;
+
+ public:
+  ContiguousArray(size_t capacity, T default_value = nullptr)
+      : default_value_(default_value)
+      , capacity_(capacity < 2 ? 2 : capacity)
+      , length_(2 * capacity_ + 1)
+      , array_(this->allocate_elements(length_, default_value))
+      , claimed_(0) {}
+
+  ~ContiguousArray() {
+    this->free_elements(array_, length_, default_value_);
+  }
+
+  /**
+   * This function returns the address of the specified position
+   * @param raw_pos the position
+   * @param no_add if true then a position beyond the array returns nullptr
+   * @return the address of the specified position
+   */
+  ArrayElement * get_spot(const size_t raw_pos, const bool no_add = false) {
+    if (raw_pos < length_) {
+      return &(array_[raw_pos]);
+    }
+    assert(no_add && "a position past the array was used");
+    return nullptr;
+  }
+
+  /**
+   * Returns the address of raw_pos and the number of positions that follow
+   * it, see ArrayArray::get_chunk. A position beyond the array returns
+   * nullptr and sets length to cover every position after it.
+   */
+  ArrayElement * get_chunk(const size_t raw_pos, size_t &length,
+      const bool no_add = false) {
+    if (raw_pos < length_) {
+      length = length_ - raw_pos;
+      return &(array_[raw_pos]);
+    }
+    assert(no_add && "a position past the array was used");
+    length = static_cast<size_t>(-1) - raw_pos;
+    return nullptr;
+  }
+
+  size_t capacity() {
+    return capacity_;
+  }
+
+  /**
+   * The whole array is allocated by the constructor, so this only checks
+   * that n positions fit.
+   */
+  void reserve(const size_t n, const size_t num_workers = 1) {
+    (void)n;
+    (void)num_workers;
+    assert(n <= capacity_ && "the vector's capacity was exceeded");
+  }
+
+  /**
+   * The array never grows, so there is nothing to allocate in advance.
+   */
+  void start_pregrow() {}
+
+  /**
+   * Claims room for n more values, which must be done before they are
+   * pushed or inserted, so that no value is placed past the capacity.
+   *
+   * It does not retry, so while a claim which fails is being undone another
+   * may fail although the values it claims would have fit.
+   *
+   * @return whether there was room, if not then nothing is claimed.
+   */
+  bool claim_positions(const size_t n) {
+    if (claimed_.fetch_add(n) + n > capacity_) {
+      claimed_.fetch_add(-n);
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Returns the room of n values which were popped or erased.
+   */
+  void release_positions(const size_t n) {
+    claimed_.fetch_add(-n);
+  }
+
+ private:
+  const T default_value_;
+  // The most values the vector holds.
+  const size_t capacity_;
+  // The number of positions in the array.
+  const size_t length_;
+  ArrayElement * const array_;
+  // The number of values stored or being pushed or inserted.
+  util::PaddedAtomic<size_t> claimed_;
+
+  DISALLOW_COPY_AND_ASSIGN(ContiguousArray);
+};  // class ContiguousArray
+
+}  // namespace vector
+}  // namespace wf
+}  // namespace containers
+}  // namespace tervel
+
+#endif  // __TERVEL_CONTAINERS_WF_VECTOR_CONTIGUOUS_ARRAY_H
@@ -33,15 +33,31 @@ namespace containers {
 namespace wf {
 namespace vector {
 
+/**
+ * Removes up to count values starting at idx, moving the values after them
+ * count positions forward. The chain of helpers ends at the first position
+ * without a value, and a position takes the value of the helper count
+ * positions after it, or no value if the chain ends first.
+ */
 template<typename T>
 class EraseAt : public ShiftOp<T> {
  public:
-  EraseAt(Vector<T> *vec, size_t idx)
-    : ShiftOp<T>(vec, idx)  {};
-
-  void cleanup();
-  void removedValue(T &val) {
-    val = ShiftOp<T>::helpers_.load()->value();
+  EraseAt(Vector<T> *vec, size_t idx, size_t count = 1)
+    : ShiftOp<T>(vec, idx, count, 1, true)  {};
+
+  /**
+   * Copies the values removed to values.
+   * @return the number of values removed, at most count.
+   */
+  size_t removedValues(T *values) {
+    size_t removed = 0;
+    ShiftHelper<T> *helper = ShiftOp<T>::helpers_.load();
+    while (removed < ShiftOp<T>::shift_ && helper != nullptr &&
+          helper->value() != Vector<T>::c_not_value_) {
+      values[removed++] = helper->value();
+      helper = helper->next();
+    }
+    return removed;
   }
   virtual T getValue(ShiftHelper<T> * helper);
 };
@@ -51,7 +67,7 @@ T EraseAt<T>::getValue(ShiftHelper<T> * helper) {
   assert(this->is_done());
   assert(helper != nullptr);
 
-  helper = helper->next();
+  helper = helper->link();
   if (helper == nullptr) {
     return Vector<T>::c_not_value_;
   } else {
@@ -59,27 +75,6 @@ T EraseAt<T>::getValue(ShiftHelper<T> * helper) {
   }
 }
 
-template<typename T>
-void EraseAt<T>::cleanup() {
-  ShiftHelper<T> *helper = ShiftOp<T>::helpers_.load();
-  assert(this->is_done());
-  assert(helper != nullptr);
-
-  T new_value;
-  for (size_t i = ShiftOp<T>::idx_; helper != nullptr; i++) {
-    T helper_marked = reinterpret_cast<T>(util::memory::rc::mark_first(helper));
-    helper = helper->next();
-    if (helper == nullptr) {
-      new_value = Vector<T>::c_not_value_;
-    } else {
-      new_value = helper->value();
-    }
-
-    std::atomic<T> *spot = ShiftOp<T>::vec_->internal_array.get_spot(i);
-    spot->compare_exchange_strong(helper_marked, new_value);
-  }  // For loop
-}
-
 }  // namespace vector
 }  // namespace wf
 }  // namespace containers
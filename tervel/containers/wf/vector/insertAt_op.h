@@ -26,6 +26,8 @@ THE SOFTWARE.
 #define __TERVEL_CONTAINERS_WF_VECTOR_INSERTAT_OP_H
 
 
+#include <vector>
+
 #include <tervel/containers/wf/vector/shift_op.h>
 
 namespace tervel {
@@ -33,56 +35,35 @@ namespace containers {
 namespace wf {
 namespace vector {
 
+/**
+ * Inserts count values at idx, moving the values from idx onward count
+ * positions back. The chain of helpers ends once count positions without a
+ * value have been covered, as they receive the last count values.
+ */
 template<typename T>
 class InsertAt : public ShiftOp<T> {
  public:
-  InsertAt(Vector<T> *vec, size_t idx, T val)
-    : ShiftOp<T>(vec, idx)
-    , val_(val) {};
+  InsertAt(Vector<T> *vec, size_t idx, const T *values, size_t count)
+    : ShiftOp<T>(vec, idx, count, count, false)
+    , values_(values, values + count) {};
 
-  void cleanup();
   virtual T getValue(ShiftHelper<T> * helper);
 
  private:
-  T val_;
+  std::vector<T> values_;
 };
 
 template<typename T>
 T InsertAt<T>::getValue(ShiftHelper<T> * helper) {
   assert(this->is_done());
   assert(helper != nullptr);
-  if (ShiftOp<T>::helpers_.load() == helper) {
-    return val_;
+  if (helper->link() == nullptr) {
+    return values_[helper->offset()];
   } else {
-    return helper->prev()->value();
+    return helper->link()->value();
   }
 }
 
-template<typename T>
-void InsertAt<T>::cleanup() {
-  ShiftHelper<T> *helper = ShiftOp<T>::helpers_.load();
-  assert(this->is_done());
-  assert(helper != nullptr);
-
-  T helper_marked = reinterpret_cast<T>(util::memory::rc::mark_first(helper));
-  std::atomic<T> *spot = ShiftOp<T>::vec_->internal_array.get_spot(ShiftOp<T>::idx_);
-  T new_value = this->val_;
-  spot->compare_exchange_strong(helper_marked, new_value);
-
-
-  for (size_t i = ShiftOp<T>::idx_ + 1; ; i++) {
-    new_value = helper->value();
-    helper = helper->next();
-    if (helper == nullptr) {
-      return;
-    }
-
-    helper_marked = reinterpret_cast<T>(util::memory::rc::mark_first(helper));
-    spot = ShiftOp<T>::vec_->internal_array.get_spot(i);
-    spot->compare_exchange_strong(helper_marked, new_value);
-  }  // For loop
-}
-
 }  // namespace vector
 }  // namespace wf
 }  // namespace containers
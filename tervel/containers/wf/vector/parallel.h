@@ -0,0 +1,183 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef __TERVEL_CONTAINERS_WF_VECTOR_PARALLEL_H
+#define __TERVEL_CONTAINERS_WF_VECTOR_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <tervel/util/util.h>
+#include <tervel/containers/wf/vector/vector.hpp>
+
+/**
+ * Scans of a whole Vector which split its positions across worker threads.
+ *
+ * The workers are plain threads, not Tervel threads: they only load
+ * positions with Vector::walk_range, so they need no ThreadContext and do not
+ * use up the Tervel object's thread ids. A position holding another thread's
+ * operation is passed back to the calling thread, which must be a Tervel
+ * thread, and is read with at() after the workers finish.
+ *
+ * Like Vector::for_each_range, the scans are weakly consistent, and they
+ * cover the positions below the vector's size when they start.
+ */
+
+namespace tervel {
+namespace containers {
+namespace wf {
+namespace vector {
+
+/**
+ * @brief Runs body(worker, begin, end, deferred) on num_workers threads until
+ * [0, vec->size()) has been covered.
+ *
+ * @details Workers take blocks of TERVEL_VECTOR_PARALLEL_BLOCK positions
+ * from a shared counter, so a worker which finishes early takes more of the
+ * larger, later segments. Positions body adds to deferred are returned.
+ *
+ * @param num_workers the number of threads, 0 uses one per hardware thread
+ */
+template<typename T, typename Body>
+std::vector<size_t> parallel_scan(Vector<T> *vec, size_t num_workers,
+    Body body) {
+  if (num_workers == 0) {
+    num_workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+  const size_t end = vec->size();
+  std::atomic<size_t> next(0);
+  std::vector<std::vector<size_t> > deferred(num_workers);
+
+  std::vector<std::thread> workers;
+  for (size_t w = 0; w < num_workers; w++) {
+    workers.emplace_back([&, w]() {
+      while (true) {
+        size_t begin = next.fetch_add(TERVEL_VECTOR_PARALLEL_BLOCK,
+              std::memory_order_relaxed);
+        if (begin >= end) {
+          break;
+        }
+        body(w, begin, std::min(end, begin + TERVEL_VECTOR_PARALLEL_BLOCK),
+              deferred[w]);
+      }
+    });
+  }
+  for (size_t w = 0; w < num_workers; w++) {
+    workers[w].join();
+  }
+
+  std::vector<size_t> res;
+  for (size_t w = 0; w < num_workers; w++) {
+    res.insert(res.end(), deferred[w].begin(), deferred[w].end());
+  }
+  return res;
+}
+
+/**
+ * @brief Calls fn(pos, value) for each value in the vector.
+ *
+ * @details fn is called concurrently by the workers, in no particular order,
+ * and must not use Tervel containers.
+ *
+ * @param vec the vector to scan
+ * @param fn the function to call
+ * @param num_workers the number of threads, 0 uses one per hardware thread
+ */
+template<typename T, typename Function>
+void parallel_for_each(Vector<T> *vec, Function fn, size_t num_workers = 0) {
+  std::vector<size_t> deferred = parallel_scan(vec, num_workers,
+        [vec, &fn](size_t, size_t begin, size_t end,
+            std::vector<size_t> &worker_deferred) {
+    vec->walk_range(begin, end, [&fn](size_t pos, T value) {
+      fn(pos, value);
+    }, [&worker_deferred](size_t pos) {
+      worker_deferred.push_back(pos);
+    });
+  });
+
+  for (size_t pos : deferred) {
+    T value;
+    if (vec->at(pos, value)) {
+      fn(pos, value);
+    }
+  }
+}
+
+/**
+ * @brief Reduces the values in the vector.
+ *
+ * @details Each worker folds the values it reads into its own result with
+ * reduce, starting from identity, and the workers' results are then merged
+ * with combine. Values are folded in no particular order, so both must be
+ * associative and commutative, and neither may use Tervel containers.
+ *
+ * @param vec the vector to scan
+ * @param identity the result of reducing no values
+ * @param reduce returns the result of folding a value, reduce(R, T)
+ * @param combine returns the result of merging two results, combine(R, R)
+ * @param num_workers the number of threads, 0 uses one per hardware thread
+ * @return the reduction of the values.
+ */
+template<typename T, typename R, typename Reduce, typename Combine>
+R parallel_reduce(Vector<T> *vec, R identity, Reduce reduce, Combine combine,
+    size_t num_workers = 0) {
+  if (num_workers == 0) {
+    num_workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+  std::vector<R> partial(num_workers, identity);
+
+  std::vector<size_t> deferred = parallel_scan(vec, num_workers,
+        [vec, &reduce, &partial](size_t worker, size_t begin, size_t end,
+            std::vector<size_t> &worker_deferred) {
+    // Kept in a local so workers do not share the lines of partial.
+    R res = partial[worker];
+    vec->walk_range(begin, end, [&reduce, &res](size_t, T value) {
+      res = reduce(res, value);
+    }, [&worker_deferred](size_t pos) {
+      worker_deferred.push_back(pos);
+    });
+    partial[worker] = res;
+  });
+
+  R res = identity;
+  for (size_t w = 0; w < num_workers; w++) {
+    res = combine(res, partial[w]);
+  }
+  for (size_t pos : deferred) {
+    T value;
+    if (vec->at(pos, value)) {
+      res = reduce(res, value);
+    }
+  }
+  return res;
+}
+
+}  // namespace vector
+}  // namespace wf
+}  // namespace containers
+}  // namespace tervel
+
+#endif  // __TERVEL_CONTAINERS_WF_VECTOR_PARALLEL_H
@@ -0,0 +1,193 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef __TERVEL_CONTAINERS_WF_VECTOR_PAYLOAD_VECTOR_H
+#define __TERVEL_CONTAINERS_WF_VECTOR_PAYLOAD_VECTOR_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <type_traits>
+
+#include <tervel/util/util.h>
+#include <tervel/containers/wf/vector/array_array.h>
+
+namespace tervel {
+namespace containers {
+namespace wf {
+namespace vector {
+
+/**
+ * @brief An append only vector of integers which stores any value of T,
+ * including values with the low bits set and zero.
+ *
+ * @details Vector reserves the two low bits of each element to mark
+ * descriptors, and zero to mark a position without a value, so integers must
+ * be shifted before they are stored. This vector places no descriptors in
+ * its elements: push_back reserves a position with a fetch_add on the size,
+ * writes the value and then sets the position's byte in a presence map, and
+ * the other operations are single atomic instructions on the value, so every
+ * operation is wait-free without helping.
+ *
+ * The values and the presence map are each stored in an ArrayArray, with the
+ * same segments, so a position's byte is found the same way as its value.
+ *
+ * Elements can not be removed, so it suits counters and ids which are
+ * appended and then updated in place.
+ *
+ * @tparam T an integer type of at most 64 bits
+ */
+template<typename T = uint64_t>
+class PayloadVector {
+  static_assert(std::is_integral<T>::value && sizeof(T) <= sizeof(uint64_t),
+        "PayloadVector stores integers of at most 64 bits");
+
+ public:
+  explicit PayloadVector(const size_t capacity = 64)
+    : values_(capacity, T(0))
+    , present_(capacity, 0) {}
+
+  /**
+   * Appends value.
+   * @return the position of the value.
+   */
+  size_t push_back(const T value) {
+    const size_t pos = size_.fetch_add(1);
+    values_.get_spot(pos)->store(value, std::memory_order_relaxed);
+    present_.get_spot(pos)->store(1, std::memory_order_release);
+    return pos;
+  }
+
+  /**
+   * Appends the values of [first, last) at consecutive positions, reserved
+   * with a single update of the size and written a segment at a time.
+   * @return the position of the first value.
+   */
+  template<typename ForwardIterator>
+  size_t push_back_range(ForwardIterator first, ForwardIterator last) {
+    size_t remaining = std::distance(first, last);
+    const size_t placed_pos = size_.fetch_add(remaining);
+    size_t pos = placed_pos;
+    while (remaining > 0) {
+      size_t length, present_length;
+      std::atomic<T> *spot = values_.get_chunk(pos, length);
+      std::atomic<uint8_t> *present = present_.get_chunk(pos, present_length);
+      assert(length == present_length);
+      length = std::min(length, remaining);
+
+      for (size_t i = 0; i < length; i++, ++first) {
+        spot[i].store(*first, std::memory_order_relaxed);
+      }
+      for (size_t i = 0; i < length; i++) {
+        present[i].store(1, std::memory_order_release);
+      }
+      pos += length;
+      remaining -= length;
+    }
+    return placed_pos;
+  }
+
+  /**
+   * @param idx the position to read
+   * @param value set to the value at idx
+   * @return whether a value has been placed at idx.
+   */
+  bool at(const size_t idx, T &value) {
+    std::atomic<T> *spot = get_present_spot(idx);
+    if (spot == nullptr) {
+      return false;
+    }
+    value = spot->load(std::memory_order_relaxed);
+    return true;
+  }
+
+  /**
+   * Replaces the value at idx with value, if it is expected.
+   * @param expected set to the value at idx if it was not expected
+   * @return whether the value was replaced, false if idx has no value or it
+   * was not expected.
+   */
+  bool cas(const size_t idx, T &expected, const T value) {
+    std::atomic<T> *spot = get_present_spot(idx);
+    if (spot == nullptr) {
+      return false;
+    }
+    return spot->compare_exchange_strong(expected, value);
+  }
+
+  /**
+   * Adds delta to the value at idx.
+   * @param prior set to the value at idx before delta was added
+   * @return whether idx has a value.
+   */
+  bool fetch_add(const size_t idx, const T delta, T &prior) {
+    std::atomic<T> *spot = get_present_spot(idx);
+    if (spot == nullptr) {
+      return false;
+    }
+    prior = spot->fetch_add(delta);
+    return true;
+  }
+
+  /**
+   * @return the number of positions reserved, a position below it may not
+   * have its value yet.
+   */
+  size_t size() {
+    return size_.load();
+  }
+
+  size_t capacity() {
+    return values_.capacity();
+  }
+
+ private:
+  /**
+   * @return the address of the value at idx, or nullptr if no value has been
+   * placed there.
+   */
+  std::atomic<T> * get_present_spot(const size_t idx) {
+    std::atomic<uint8_t> *present = present_.get_spot(idx, true);
+    if (present == nullptr ||
+          present->load(std::memory_order_acquire) == 0) {
+      return nullptr;
+    }
+    return values_.get_spot(idx, true);
+  }
+
+  ArrayArray<T> values_;
+  ArrayArray<uint8_t> present_;
+  std::atomic<size_t> size_ {0};
+
+  DISALLOW_COPY_AND_ASSIGN(PayloadVector);
+};  // class PayloadVector
+
+}  // namespace vector
+}  // namespace wf
+}  // namespace containers
+}  // namespace tervel
+
+#endif  // __TERVEL_CONTAINERS_WF_VECTOR_PAYLOAD_VECTOR_H
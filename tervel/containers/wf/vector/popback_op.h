@@ -50,7 +50,7 @@ class PopOpSubHelper;
 template<typename T>
 class PopOp: public tervel::util::OpRecord {
  public:
-  static constexpr PopOpHelper<T> * is_empty_const {reinterpret_cast<PopOpHelper<T> *>(0x1L)};
+  static PopOpHelper<T> * const is_empty_const;
 
   PopOp(Vector<T> *vec)
     : vec_(vec) {}
@@ -241,10 +241,13 @@ class PopOp: public tervel::util::OpRecord {
   std::atomic<PopOpHelper<T> *> helper_ {nullptr};
 };  // class PopOp
 
+template<typename T>
+PopOpHelper<T> * const PopOp<T>::is_empty_const = reinterpret_cast<PopOpHelper<T> *>(0x1L);
+
 template<typename T>
 class PopOpHelper: public tervel::util::Descriptor {
  public:
-  static constexpr PopOpSubHelper<T> * fail_const {reinterpret_cast<PopOpSubHelper<T> *>(0x1L)};
+  static PopOpSubHelper<T> * const fail_const;
 
 
   PopOpHelper(Vector<T> * vec, PopOp<T> *op)
@@ -431,6 +434,9 @@ class PopOpHelper: public tervel::util::Descriptor {
   std::atomic<PopOpSubHelper<T> *> child_ {nullptr};
 };
 
+template<typename T>
+PopOpSubHelper<T> * const PopOpHelper<T>::fail_const = reinterpret_cast<PopOpSubHelper<T> *>(0x1L);
+
 template<typename T>
 class PopOpSubHelper: public tervel::util::Descriptor {
  public:
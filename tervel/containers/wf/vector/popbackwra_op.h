@@ -46,7 +46,7 @@ class PopWRAOpHelper;
 template<typename T>
 class PopWRAOp: public tervel::util::OpRecord {
  public:
-  static constexpr PopWRAOpHelper<T> * is_empty_const {reinterpret_cast<PopWRAOpHelper<T> *>(0x1L)};
+  static PopWRAOpHelper<T> * const is_empty_const;
 
   PopWRAOp(Vector<T> *vec)
     : vec_(vec) {}
@@ -138,6 +138,9 @@ class PopWRAOp: public tervel::util::OpRecord {
   std::atomic<PopWRAOpHelper<T> *> helper_ {nullptr};
 };  // class PopOp
 
+template<typename T>
+PopWRAOpHelper<T> * const PopWRAOp<T>::is_empty_const = reinterpret_cast<PopWRAOpHelper<T> *>(0x1L);
+
 template<typename T>
 class PopWRAOpHelper: public tervel::util::Descriptor {
  public:
@@ -50,12 +50,31 @@ class ShiftHelper: public tervel::util::Descriptor {
   ShiftHelper * prev() { return prev_; };
   T value() { return value_; };
   ShiftOp<T> * op() { return op_;};
-  bool end(T val) { return value_ == val; };
   void set_value(T value) { value_ = value; };
   void set_prev(ShiftHelper<T> *prev) {
     assert(prev->isAssociatedWithMe());
     prev_ = prev;
   }
+
+  // The helper whose value this position takes, the one shift positions
+  // before it for an insert or after it for an erase, see ShiftOp::place_rest.
+  // An insert's first shift positions have no such helper and instead record
+  // their distance from the op's first position in the same word, tagged by
+  // its lowest bit, which keeps the helper within a pool element.
+  ShiftHelper<T> * link() {
+    uintptr_t link = link_.load();
+    return (link & 0x1) ? nullptr : reinterpret_cast<ShiftHelper<T> *>(link);
+  };
+  void set_link(ShiftHelper<T> *link) {
+    link_.store(reinterpret_cast<uintptr_t>(link));
+  };
+  size_t offset() {
+    assert(link_.load() & 0x1);
+    return static_cast<size_t>(link_.load() >> 1);
+  };
+  void set_offset(size_t offset) {
+    link_.store((static_cast<uintptr_t>(offset) << 1) | 0x1);
+  };
   bool associate(ShiftHelper<T> *next) {
     ShiftHelper<T> *expected = next_.load();
     if (expected == nullptr && next_.compare_exchange_strong(expected, next)) {
@@ -143,6 +162,7 @@ class ShiftHelper: public tervel::util::Descriptor {
   ShiftHelper<T> *prev_;
   std::atomic<ShiftHelper<T> *> next_{nullptr};
   T value_;
+  std::atomic<uintptr_t> link_ {0};
 };
 
 }  // namespace vector
@@ -53,8 +53,21 @@ class ShiftOp: public tervel::util::OpRecord {
   friend class ShiftHelper<T>;
 
 
-  ShiftOp(Vector<T> *vec, size_t idx)
+  /**
+   * @param vec the vector
+   * @param idx the first position changed
+   * @param shift the number of positions the values move by
+   * @param end_run the number of consecutive positions without a value which
+   * end the shift
+   * @param link_ahead whether a helper is linked to the one shift positions
+   * after it (an erase), rather than before it (an insert)
+   */
+  ShiftOp(Vector<T> *vec, size_t idx, size_t shift, size_t end_run,
+      bool link_ahead)
     : idx_(idx)
+    , shift_(shift)
+    , end_run_(end_run)
+    , link_ahead_(link_ahead)
     , vec_(vec) {};
 
   ~ShiftOp();
@@ -127,6 +140,9 @@ class ShiftOp: public tervel::util::OpRecord {
   // getValue - returns the value of the helper based on the state of the
   // operation.
   virtual T getValue(ShiftHelper<T> * helper) = 0;
+
+  // cleanup - replaces each helper with its value, once the op is done.
+  void cleanup();
  private:
   // wait_free_return encapsulates logic to determine if the function should
   // return in case the operation has been completed or if it should giveup
@@ -136,16 +152,24 @@ class ShiftOp: public tervel::util::OpRecord {
 
 
   size_t idx_;
+  // the number of positions values move by
+  const size_t shift_;
+  // the number of trailing helpers which found no value that end the chain
+  const size_t end_run_;
+  // see ShiftHelper::link
+  const bool link_ahead_;
   Vector<T> *vec_;
   std::atomic<ShiftHelper<T> *> helpers_{nullptr};
   std::atomic<bool> is_done_{false};
 
-  static constexpr ShiftHelper<T> * k_fail_const {
-    reinterpret_cast<ShiftHelper<T> *>(0x1L)
-  };
+  static ShiftHelper<T> * const k_fail_const;
 
 };  // class ShiftOp
 
+template<typename T>
+ShiftHelper<T> * const ShiftOp<T>::k_fail_const =
+    reinterpret_cast<ShiftHelper<T> *>(0x1L);
+
 template<typename T>
 ShiftOp<T>::~ShiftOp() {
   ShiftHelper<T> *helper = helpers_.load();
@@ -183,6 +207,9 @@ void ShiftOp<T>::place_first_idx(bool announced) {
   ShiftHelper<T> *helper = tervel::util::memory::rc::get_descriptor<
         ShiftHelper<T> >(this);
   T helper_marked = reinterpret_cast<T>(util::memory::rc::mark_first(helper));
+  if (!link_ahead_) {
+    helper->set_offset(0);
+  }
 
   std::atomic<T> *spot = vec_->internal_array.get_spot(idx_);
 
@@ -203,7 +230,7 @@ void ShiftOp<T>::place_first_idx(bool announced) {
     } else if (vec_->internal_array.is_descriptor(expected, spot)) {
       // The is_descriptor function changes the value at the address
       if (tervel::util::RecursiveAction::recursive_return() &&
-          this != tl_control_word) {
+          state() != tl_control_word) {
         return;
       }
     } else {  // its a valid value
@@ -230,14 +257,42 @@ void ShiftOp<T>::place_rest(bool announced) {
 
   ShiftHelper<T> *helper = nullptr;
   T helper_marked;
+  // Every thread walks the chain from its start, so each keeps the helper
+  // shift_ positions behind the one it is at and the number of consecutive
+  // helpers which found no value. Both are the same for every thread.
+  ShiftHelper<T> *back = nullptr;
+  size_t empty_run = 0;
   for (size_t i = idx_ + 1; !is_done() ; i++) {
     assert(last_helper != nullptr);
 
-    if (last_helper->end(Vector<T>::c_not_value_)) {
+    // back becomes the helper shift_ positions before last_helper.
+    if (i - 1 - idx_ == shift_) {
+      back = helpers_.load();
+    } else if (back != nullptr) {
+      back = back->next();
+    }
+    if (link_ahead_ && back != nullptr) {
+      back->set_link(last_helper);
+    }
+
+    if (last_helper->value() == Vector<T>::c_not_value_) {
+      empty_run++;
+    } else {
+      empty_run = 0;
+    }
+    if (empty_run >= end_run_) {
       set_done();
       break;
     }
 
+    // The helper shift_ positions before position i.
+    ShiftHelper<T> *new_back = nullptr;
+    if (i - idx_ == shift_) {
+      new_back = helpers_.load();
+    } else if (back != nullptr) {
+      new_back = back->next();
+    }
+
     if (helper == nullptr) {
       helper = tervel::util::memory::rc::get_descriptor<
         ShiftHelper<T> >(this);
@@ -258,6 +313,13 @@ void ShiftOp<T>::place_rest(bool announced) {
 
       T expected = spot->load();
       helper->set_value(expected);
+      if (!link_ahead_) {
+        if (new_back == nullptr) {
+          helper->set_offset(i - idx_);
+        } else {
+          helper->set_link(new_back);
+        }
+      }
       if (expected != Vector<T>::c_not_value_ &&
           vec_->internal_array.shift_is_descriptor(expected, spot, this)) {
         if (tervel::util::RecursiveAction::recursive_return()) {
@@ -289,6 +351,20 @@ void ShiftOp<T>::place_rest(bool announced) {
   }
 }
 
+template<typename T>
+void ShiftOp<T>::cleanup() {
+  assert(this->is_done());
+  ShiftHelper<T> *helper = helpers_.load();
+  assert(helper != nullptr);
+
+  for (size_t i = idx_; helper != nullptr; i++) {
+    T helper_marked = reinterpret_cast<T>(util::memory::rc::mark_first(helper));
+    std::atomic<T> *spot = vec_->internal_array.get_spot(i);
+    spot->compare_exchange_strong(helper_marked, getValue(helper));
+    helper = helper->next();
+  }  // For loop
+}
+
 template<typename T>
 bool ShiftOp<T>::wait_free_giveup(
   bool announced,
@@ -296,7 +372,7 @@ bool ShiftOp<T>::wait_free_giveup(
   // Check if we are delayed, ignore delay if this is helping as a result
   // of progress assurance.
   if (!announced && p.isDelayed()) {
-    if (this == tl_control_word) {
+    if (state() == tl_control_word) {
       // Delayed while attempting complete the thread's own shift operation.
       // So we need to make an announcement
       util::ProgressAssurance::make_announcement(
@@ -0,0 +1,93 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef __TERVEL_CONTAINERS_WF_VECTOR_SNAPSHOT_OP_H
+#define __TERVEL_CONTAINERS_WF_VECTOR_SNAPSHOT_OP_H
+
+#include <atomic>
+#include <vector>
+
+#include <tervel/util/info.h>
+#include <tervel/util/progress_assurance.h>
+
+#include <tervel/containers/wf/vector/vector.hpp>
+
+namespace tervel {
+namespace containers {
+namespace wf {
+namespace vector {
+
+/**
+ * Announced by a snapshot whose attempts keep failing. Each thread which
+ * helps makes attempts until one of them, or another helper, succeeds, and
+ * the first copy taken is the result. A helper makes no other changes to the
+ * vector while it helps, so once every thread is helping an attempt
+ * succeeds.
+ */
+template<typename T>
+class SnapshotOp: public tervel::util::OpRecord {
+ public:
+  explicit SnapshotOp(Vector<T> *vec)
+    : vec_(vec) {}
+
+  ~SnapshotOp() {
+    delete result_.load();
+  }
+
+  void help_complete() {
+    std::vector<T> *values = new std::vector<T>();
+    while (result_.load() == nullptr) {
+      if (vec_->try_snapshot(*values)) {
+        std::vector<T> *expected = nullptr;
+        if (result_.compare_exchange_strong(expected, values)) {
+          return;
+        }
+        break;
+      }
+    }
+    delete values;
+  }
+
+  /**
+   * Moves the copy taken into values.
+   */
+  void result(std::vector<T> &values) {
+    std::vector<T> *temp = result_.load();
+    assert(temp != nullptr);
+    values.swap(*temp);
+  }
+
+ private:
+  Vector<T> *vec_;
+  std::atomic<std::vector<T> *> result_ {nullptr};
+
+  DISALLOW_COPY_AND_ASSIGN(SnapshotOp);
+};  // class SnapshotOp
+
+}  // namespace vector
+}  // namespace wf
+}  // namespace containers
+}  // namespace tervel
+
+#endif  // __TERVEL_CONTAINERS_WF_VECTOR_SNAPSHOT_OP_H
@@ -31,10 +31,15 @@ THE SOFTWARE.
 #include <assert.h>
 #include <limits.h>
 #include <stdint.h>
+#include <algorithm>
+#include <iterator>
 #include <memory>
+#include <vector>
 
 #include <tervel/util/util.h>
+#include <tervel/util/sharded_counter.h>
 #include <tervel/containers/wf/vector/array_array.h>
+#include <tervel/containers/wf/vector/contiguous_array.h>
 
 namespace tervel {
 namespace containers {
@@ -44,6 +49,12 @@ namespace vector {
 template<typename T>
 class Vector {
  public:
+#ifdef TERVEL_VECTOR_CONTIGUOUS
+  typedef ContiguousArray<T> InternalArray;
+#else
+  typedef ArrayArray<T> InternalArray;
+#endif
+
   explicit Vector(const size_t capacity = 64)
     : current_size_(0)
     , internal_array(capacity, c_not_value_) {}
@@ -51,10 +62,35 @@ class Vector {
   bool at(size_t idx, T &value);
   bool cas(size_t idx, T &expValue, const T newValue);
 
+  // Each returns the position of value, or -1 if it does not fit in the
+  // capacity of a vector which does not grow.
   size_t push_back_only(T value);
   size_t push_back_w_ra(T value);
   size_t push_back(T value);
 
+  /**
+   * Appends the values of [first, last) at consecutive positions, reserving
+   * them with a single update of the size and writing them a segment at a
+   * time. Like push_back_only, it must not be mixed with the other push and
+   * pop operations.
+   *
+   * @return the position of the first value, or -1 if they do not fit in
+   * the capacity of a vector which does not grow.
+   */
+  template<typename ForwardIterator>
+  size_t push_back_range_only(ForwardIterator first, ForwardIterator last);
+
+  /**
+   * Appends the values of [first, last) in order, each as push_back_w_ra
+   * does, but continuing from the position of the previous value. Values
+   * pushed by other threads may be placed between them.
+   *
+   * @return the position of the first value, or -1 if they do not fit in
+   * the capacity of a vector which does not grow.
+   */
+  template<typename ForwardIterator>
+  size_t push_back_range_w_ra(ForwardIterator first, ForwardIterator last);
+
   bool pop_back_only(T &value);
   bool pop_back_w_ra(T &value);
   bool pop_back(T &value);
@@ -62,6 +98,74 @@ class Vector {
   bool insertAt(size_t pos, T value);
   bool eraseAt(size_t pos, T &value);
 
+  /**
+   * Inserts count values at pos, moving the values from pos onward count
+   * positions back in a single pass, so each position is shifted once rather
+   * than count times.
+   *
+   * @return whether the values were inserted, false if pos holds no value
+   * or they do not fit in the capacity of a vector which does not grow.
+   */
+  bool insertAt(size_t pos, const T *values, size_t count);
+
+  /**
+   * Removes up to count values starting at pos, moving the values after them
+   * count positions forward in a single pass.
+   *
+   * @param values an array of at least count elements, set to the values
+   * removed
+   * @return the number of values removed, fewer than count if the vector
+   * ends first and 0 if pos holds no value.
+   */
+  size_t eraseAt(size_t pos, size_t count, T *values);
+
+  /**
+   * Calls fn(pos, value) for each position in [begin, end) which holds a
+   * value, in order. It is weakly consistent: each value was at its position
+   * at some point during the call, but operations which run concurrently may
+   * or may not be seen. The positions are read a segment at a time without
+   * the per call overhead of at(), only a position holding another thread's
+   * operation is read with at().
+   */
+  template<typename Function>
+  void for_each_range(size_t begin, size_t end, Function fn);
+
+  /**
+   * Calls fn(pos, value) for each position in [begin, end) which holds a
+   * value and on_descriptor(pos) for each position which holds another
+   * thread's operation, which it does not help. It only loads positions, so
+   * it may be called by a thread which has no ThreadContext, see
+   * parallel.h.
+   */
+  template<typename Function, typename DescriptorFunction>
+  void walk_range(size_t begin, size_t end, Function fn,
+      DescriptorFunction on_descriptor);
+
+  /**
+   * Sets values to a copy of the vector as it was at a single point during
+   * the call, the values at positions [0, n) where position n held no value.
+   *
+   * Each attempt, see try_snapshot, fails if another operation changes the
+   * vector while the copy is taken, so under a steady stream of updates an
+   * attempt may never succeed. After TERVEL_VECTOR_SNAPSHOT_ATTEMPTS failed
+   * attempts the snapshot is announced, see SnapshotOp, and the threads which
+   * help it stop updating the vector until it completes, so it is wait-free.
+   * It must not be mixed with the _only operations, which store without a
+   * compare and swap and do not help announcements.
+   */
+  void snapshot(std::vector<T> &values);
+
+  /**
+   * Makes one attempt of snapshot. The positions are read a segment at a
+   * time and read again, then a multi-word compare and swap, which expects
+   * and writes back each value read, checks that none of them changed. Its
+   * cost is linear in the size of the vector.
+   *
+   * @return whether values holds a copy of the vector, false if another
+   * operation changed it during the attempt.
+   */
+  bool try_snapshot(std::vector<T> &values);
+
   int64_t size() {
     int64_t temp = current_size_.load();
     if (temp < 0)
@@ -74,8 +178,37 @@ class Vector {
     return internal_array.capacity();
   };
 
-  static constexpr T c_not_value_ {static_cast<T>(0x1L)};
+  /**
+   * Allocates the storage for the first n positions now, so operations on
+   * them do not allocate it.
+   *
+   * @param n the number of positions
+   * @param num_workers the number of threads to allocate with
+   */
+  void reserve(size_t n, size_t num_workers = 1) {
+    internal_array.reserve(n, num_workers);
+  };
+
+  /**
+   * Starts a thread which allocates the next segment before the positions
+   * already allocated run out, see ArrayArray::start_pregrow.
+   */
+  void start_pregrow() {
+    internal_array.start_pregrow();
+  };
 
+  /**
+   * The value of a position which holds no value. It is zero so that storage
+   * comes from zero filled pages without being initialised, see
+   * VectorArray::allocate_elements.
+   */
+  static constexpr T c_not_value_ {static_cast<T>(0)};
+
+  /**
+   * Adjusts the size by val, returning the prior size. The _only operations
+   * derive positions from the result, so it is always exact when only they are
+   * used, see util::ShardedCounter::fetch_add.
+   */
   int64_t size(int64_t val) {
     int64_t temp = current_size_.fetch_add(val);
     if (temp < 0)
@@ -84,8 +217,17 @@ class Vector {
       return temp;
   }
 
-  std::atomic<int64_t> current_size_ {0};
-  ArrayArray<T> internal_array;
+  /**
+   * Adjusts the size by val, used by the operations which do not derive
+   * positions from the size. With TERVEL_SHARDED_SIZE defined this does not
+   * update a shared variable.
+   */
+  void size_add(int64_t val) {
+    current_size_.add(val);
+  }
+
+  util::SizeCounter current_size_;
+  InternalArray internal_array;
 };  // class Vector
 }
 }
@@ -25,6 +25,11 @@ THE SOFTWARE.
 #ifndef __TERVEL_CONTAINERS_WF_VECTOR_VECTOR_ARRAY_H
 #define __TERVEL_CONTAINERS_WF_VECTOR_VECTOR_ARRAY_H
 
+#include <sys/mman.h>
+
+#include <atomic>
+#include <new>
+
 #include <tervel/util/info.h>
 #include <tervel/util/descriptor.h>
 #include <tervel/util/memory/rc/descriptor_util.h>
@@ -36,47 +41,117 @@ namespace containers {
 namespace wf {
 namespace vector {
 
+/**
+ * The base of the classes which store the vector's elements. Vector holds its
+ * layout by value and calls it directly, so none of these calls are virtual
+ * and the checks below inline into the operations.
+ *
+ * A layout must provide:
+ *   std::atomic<T> * get_spot(const size_t raw_pos, const bool no_add)
+ *   std::atomic<T> * get_chunk(const size_t raw_pos, size_t &length,
+ *                              const bool no_add)
+ *   size_t capacity()
+ *   void reserve(const size_t n, const size_t num_workers)
+ *   void start_pregrow()
+ *   bool claim_positions(const size_t n)
+ *   void release_positions(const size_t n)
+ * and may hide is_descriptor or shift_is_descriptor, for example to detect a
+ * resize.
+ *
+ * @tparam T the type of the elements
+ */
 template<typename T>
 class VectorArray {
  public:
-  explicit VectorArray() {}
-  explicit VectorArray(size_t capacity) {}
-  virtual ~VectorArray() {}
-
   /**
-   * This function returns the address of the specified position
-   * @param raw_pos the position
-   * @param no_add if true then it will not increase the vectors size
-   * @return the address of the specified position
+   * @return whether value may be stored, its two lowest bits are reserved to
+   * mark descriptors and zero marks a position without a value.
    */
-  virtual std::atomic<T> * get_spot(const size_t raw_pos,
-      const bool no_add = false) = 0;
-
-  virtual bool is_valid(T value) {
+  static bool is_valid(T value) {
     uint64_t val = uint64_t(value);
-    val = val & uint64_t(0x3);
-    return val == uint64_t(0);
+    return val != uint64_t(0) && (val & uint64_t(0x3)) == uint64_t(0);
   }
 
   /**
-   * Overridden by SingleArray model to detect resize.
-   * @param  expected [description]
-   * @param  spot     [description]
-   * @return          [description]
+   * If expected is a descriptor, it completes it and loads the spot's new
+   * value into expected.
+   * @param  expected the value read from spot
+   * @param  spot     the address it was read from
+   * @return          whether or not expected was a descriptor
    */
-  virtual bool is_descriptor(T &expected, std::atomic<T> *spot);
+  bool is_descriptor(T &expected, std::atomic<T> *spot);
 
   /**
-   * Overridden by SingleArray model to detect resize.
-   * @param  expected [description]
-   * @param  spot     [description]
-   * @return          [description]
+   * The version of is_descriptor used by the shift operations, which does not
+   * help the shift op was passed.
+   * @param  expected the value read from spot
+   * @param  spot     the address it was read from
+   * @param  op       the shift operation being performed
+   * @return          whether or not expected was a descriptor
    */
-  virtual bool shift_is_descriptor(T &expected, std::atomic<T> *spot, void *op);
+  bool shift_is_descriptor(T &expected, std::atomic<T> *spot, void *op);
+
+ protected:
+  VectorArray() {}
+  ~VectorArray() {}
+
+  /**
+   * Allocates n elements set to default_value.
+   *
+   * If default_value is zero, the elements come from an anonymous mapping.
+   * The kernel fills its pages with zeros when they are first touched, so no
+   * loop writes them and a large allocation costs nothing until it is used.
+   * With TERVEL_VECTOR_HUGEPAGE defined, mappings of at least 2MB are
+   * advised to use huge pages.
+   *
+   * @param n the number of elements
+   * @param default_value the value of each element
+   * @return the elements, which must be freed with free_elements
+   */
+  static std::atomic<T> * allocate_elements(const size_t n,
+      const T default_value) {
+    if (default_value == T()) {
+      const size_t bytes = n * sizeof(std::atomic<T>);
+      void *mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if (mem == MAP_FAILED) {
+        throw std::bad_alloc();
+      }
+#if defined(TERVEL_VECTOR_HUGEPAGE) && defined(MADV_HUGEPAGE)
+      if (bytes >= (size_t(2) << 20)) {
+        madvise(mem, bytes, MADV_HUGEPAGE);
+      }
+#endif
+      // std::atomic<T> is trivially constructible and all zero bits is T(0).
+      return reinterpret_cast<std::atomic<T> *>(mem);
+    }
+
+    std::atomic<T> *elements = new std::atomic<T>[n];
+    for (size_t i = 0; i < n; i++) {
+      elements[i].store(default_value, std::memory_order_relaxed);
+    }
+    return elements;
+  }
+
+  /**
+   * Frees elements returned by allocate_elements, a mapping is returned to
+   * the OS.
+   */
+  static void free_elements(std::atomic<T> *elements, const size_t n,
+      const T default_value) {
+    if (elements == nullptr) {
+      return;
+    } else if (default_value == T()) {
+      munmap(elements, n * sizeof(std::atomic<T>));
+    } else {
+      delete [] elements;
+    }
+  }
 };  // class Vector Array
 
 template<typename T>
-bool VectorArray<T>::is_descriptor(T &expected, std::atomic<T> *spot) {
+bool VectorArray<T>::is_descriptor(T &expected,
+    std::atomic<T> *spot) {
   void *temp = reinterpret_cast<void *>(expected);
   if (util::memory::rc::is_descriptor_first(temp)) {
      /* It is some other threads operation, so lets complete it.*/
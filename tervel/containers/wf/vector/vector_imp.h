@@ -27,6 +27,7 @@ THE SOFTWARE.
 
 #include <tervel/util/info.h>
 #include <tervel/util/descriptor.h>
+#include <tervel/algorithms/wf/mcas/mcas.h>
 
 #include <tervel/containers/wf/vector/vector.hpp>
 
@@ -38,6 +39,7 @@ THE SOFTWARE.
 #include <tervel/containers/wf/vector/popbackwra_op.h>
 #include <tervel/containers/wf/vector/insertAt_op.h>
 #include <tervel/containers/wf/vector/eraseAt_op.h>
+#include <tervel/containers/wf/vector/snapshot_op.h>
 
 #include <tervel/containers/wf/vector/vector_array.h>
 
@@ -52,6 +54,9 @@ size_t Vector<T>::push_back_only(T value) {
     assert(false);
     return -1;
   }
+  if (!internal_array.claim_positions(1)) {
+    return -1;
+  }
 
   size_t placed_pos = size(1);
   std::atomic<T> *spot = internal_array.get_spot(placed_pos);
@@ -68,6 +73,9 @@ size_t Vector<T>::push_back_only(T value) {
       assert(false);
       return -1;
     }
+    if (!internal_array.claim_positions(1)) {
+      return -1;
+    }
 
     size_t placed_pos = size();
 
@@ -78,7 +86,7 @@ size_t Vector<T>::push_back_only(T value) {
       T expected = spot->load();
       if ( (expected ==  Vector<T>::c_not_value_) &&
                     spot->compare_exchange_weak(expected, value) ) {
-        size(1);
+        size_add(1);
         return placed_pos;
       } else if (internal_array.is_descriptor(expected, spot)) {
         continue;
@@ -93,10 +101,100 @@ size_t Vector<T>::push_back_only(T value) {
 
     size_t result = op->result();
     op->safe_delete();
+    size_add(1);
 
     return result;
   }  // push_back_w_ra
 
+template<typename T>
+template<typename ForwardIterator>
+size_t Vector<T>::push_back_range_only(ForwardIterator first,
+    ForwardIterator last) {
+  for (ForwardIterator it = first; it != last; ++it) {
+    if (!internal_array.is_valid(*it)) {
+      assert(false);
+      return -1;
+    }
+  }
+
+  size_t remaining = std::distance(first, last);
+  if (!internal_array.claim_positions(remaining)) {
+    return -1;
+  }
+  const size_t placed_pos = size(remaining);
+  size_t pos = placed_pos;
+  while (remaining > 0) {
+    size_t length;
+    std::atomic<T> *spot = internal_array.get_chunk(pos, length);
+    length = std::min(length, remaining);
+    for (size_t i = 0; i < length; i++, ++first) {
+      spot[i].store(*first, std::memory_order_relaxed);
+    }
+    pos += length;
+    remaining -= length;
+  }
+  return placed_pos;
+}  // push_back_range_only
+
+template<typename T>
+template<typename ForwardIterator>
+size_t Vector<T>::push_back_range_w_ra(ForwardIterator first,
+    ForwardIterator last) {
+  tervel::util::ProgressAssurance::check_for_announcement();
+
+  for (ForwardIterator it = first; it != last; ++it) {
+    if (!internal_array.is_valid(*it)) {
+      assert(false);
+      return -1;
+    }
+  }
+  if (!internal_array.claim_positions(std::distance(first, last))) {
+    return -1;
+  }
+
+  size_t placed_pos = size();
+  size_t first_pos = -1;
+  int64_t placed = 0;
+  for (; first != last; ++first) {
+    const T value = *first;
+    bool done = false;
+
+    tervel::util::ProgressAssurance::Limit progAssur;
+    while (progAssur.isDelayed() == false) {
+      std::atomic<T> *spot = internal_array.get_spot(placed_pos);
+      T expected = spot->load();
+      if ( (expected ==  Vector<T>::c_not_value_) &&
+                    spot->compare_exchange_weak(expected, value) ) {
+        done = true;
+        break;
+      } else if (internal_array.is_descriptor(expected, spot)) {
+        continue;
+      } else {  // its a valid value
+          placed_pos++;
+      }
+    }
+
+    if (done) {
+      placed++;
+    } else {
+      PushWRAOp<T> *op = new PushWRAOp<T>(this, value);
+      util::ProgressAssurance::make_announcement(
+            reinterpret_cast<tervel::util::OpRecord *>(op));
+      placed_pos = op->result();
+      op->safe_delete();
+      size_add(1);
+    }
+
+    if (first_pos == static_cast<size_t>(-1)) {
+      first_pos = placed_pos;
+    }
+    placed_pos++;
+  }
+
+  size_add(placed);
+  return first_pos;
+}  // push_back_range_w_ra
+
 template<typename T>
 bool Vector<T>::pop_back_only(T &value) {
   size_t poped_pos = size(-1);
@@ -108,6 +206,7 @@ bool Vector<T>::pop_back_only(T &value) {
     std::atomic<T> *spot = internal_array.get_spot(poped_pos - 1);
     value = spot->load(std::memory_order_relaxed);
     spot->store(Vector<T>::c_not_value_, std::memory_order_relaxed);
+    internal_array.release_positions(1);
 
     return true;
   }
@@ -138,7 +237,8 @@ bool Vector<T>::pop_back_only(T &value) {
       } else if (internal_array.is_descriptor(current, spot)) {
         continue;
       }else if (spot->compare_exchange_weak(current, Vector<T>::c_not_value_)) {
-        size(-1);
+        size_add(-1);
+        internal_array.release_positions(1);
         value = current;
         return true;
       } else {
@@ -152,6 +252,10 @@ bool Vector<T>::pop_back_only(T &value) {
 
     bool result = op->result(value);
     op->safe_delete();
+    if (result) {
+      size_add(-1);
+      internal_array.release_positions(1);
+    }
 
     return result;
   }  // pop_back_w_ra
@@ -165,10 +269,13 @@ size_t Vector<T>::push_back(T value) {
     assert(false);
     return -1;
   }
+  if (!internal_array.claim_positions(1)) {
+    return -1;
+  }
 
   size_t pos = PushOp<T>::execute(this, value);
 
-  size(1);
+  size_add(1);
   return pos;
 }
 
@@ -180,11 +287,55 @@ bool Vector<T>::pop_back(T &value) {
   bool res = PopOp<T>::execute(this, value);
 
   if (res) {
-    size(-1);
+    size_add(-1);
+    internal_array.release_positions(1);
   }
   return res;
 }
 
+template<typename T>
+template<typename Function>
+void Vector<T>::for_each_range(size_t begin, size_t end, Function fn) {
+  tervel::util::ProgressAssurance::check_for_announcement();
+
+  walk_range(begin, end, [&fn](size_t pos, T value) {
+    fn(pos, value);
+  }, [this, &fn](size_t pos) {
+    T value;
+    if (at(pos, value)) {
+      fn(pos, value);
+    }
+  });
+}  // for_each_range
+
+template<typename T>
+template<typename Function, typename DescriptorFunction>
+void Vector<T>::walk_range(size_t begin, size_t end, Function fn,
+    DescriptorFunction on_descriptor) {
+  while (begin < end) {
+    size_t length;
+    std::atomic<T> *spot = internal_array.get_chunk(begin, length, true);
+    length = std::min(length, end - begin);
+
+    if (spot != nullptr) {
+      for (size_t i = 0; i < length; i++) {
+        // fn may run on a thread other than the one which stored the value,
+        // so the load must see what was written before it, e.g. the object a
+        // pointer refers to.
+        T value = spot[i].load(std::memory_order_acquire);
+        if (value == Vector<T>::c_not_value_) {
+          continue;
+        } else if (internal_array.is_valid(value)) {
+          fn(begin + i, value);
+        } else {
+          on_descriptor(begin + i);
+        }
+      }
+    }  // else the segment has not been allocated, so it holds no values
+    begin += length;
+  }
+}  // walk_range
+
 template<typename T>
 bool Vector<T>::at(size_t idx, T &value) {
   tervel::util::ProgressAssurance::check_for_announcement();
@@ -276,16 +427,35 @@ bool Vector<T>::cas(size_t idx, T &expected, const T val) {
 
 template<typename T>
 bool Vector<T>::insertAt(size_t idx, T value){
+  return insertAt(idx, &value, 1);
+};
+
+template<typename T>
+bool Vector<T>::eraseAt(size_t idx, T &value){
+  return eraseAt(idx, 1, &value) == 1;
+};
+
+template<typename T>
+bool Vector<T>::insertAt(size_t idx, const T *values, size_t count){
   // Perform bounds checking
-  if(!internal_array.is_valid(value)){
-    assert(false);
-    return false;
+  for (size_t i = 0; i < count; i++) {
+    if(!internal_array.is_valid(values[i])){
+      assert(false);
+      return false;
+    }
+  }
+  if (count == 0) {
+    return true;
   }
 
   tervel::util::ProgressAssurance::check_for_announcement();
 
+  if (!internal_array.claim_positions(count)) {
+    return false;
+  }
+
   // Create operation record
-  InsertAt<T>* op = new InsertAt<T>(this, idx, value);
+  InsertAt<T>* op = new InsertAt<T>(this, idx, values, count);
   // Set thread local value equal to control word.
   tl_control_word = op->state();
   op->execute();
@@ -294,35 +464,154 @@ bool Vector<T>::insertAt(size_t idx, T value){
     // remove remaining discriptors
     op->cleanup();
     // adjust vector size
-    size(-1);
+    size_add(count);
+  } else {
+    internal_array.release_positions(count);
   }
   op->safe_delete();
   return success;
 };
 
 template<typename T>
-bool Vector<T>::eraseAt(size_t idx, T &value){
+size_t Vector<T>::eraseAt(size_t idx, size_t count, T *values){
+  if (count == 0) {
+    return 0;
+  }
+
   tervel::util::ProgressAssurance::check_for_announcement();
 
   // Create operation record
-  EraseAt<T>* op = new EraseAt<T>(this, idx);
+  EraseAt<T>* op = new EraseAt<T>(this, idx, count);
   // Set thread local value equal to control word.
   tl_control_word = op->state();
   op->execute();
 
-  bool success = !op->isFailed();
-  if (success) {
+  size_t removed = 0;
+  if (!op->isFailed()) {
     // remove remaining discriptors
     op->cleanup();
-    // get value removed by this operation
-    op->removedValue(value);
+    // get values removed by this operation
+    removed = op->removedValues(values);
     // adjust vector size
-    size(-1);
+    size_add(-static_cast<int64_t>(removed));
+    internal_array.release_positions(removed);
   }
   op->safe_delete();
-  return success;
+  return removed;
 };
 
+template<typename T>
+void Vector<T>::snapshot(std::vector<T> &values) {
+  tervel::util::ProgressAssurance::check_for_announcement();
+
+  tervel::util::ProgressAssurance::Limit progAssur(
+        TERVEL_VECTOR_SNAPSHOT_ATTEMPTS);
+  while (progAssur.isDelayed() == false) {
+    if (try_snapshot(values)) {
+      return;
+    }
+  }
+
+  SnapshotOp<T> *op = new SnapshotOp<T>(this);
+  util::ProgressAssurance::make_announcement(
+        reinterpret_cast<tervel::util::OpRecord *>(op));
+  op->result(values);
+  op->safe_delete();
+}  // snapshot
+
+template<typename T>
+bool Vector<T>::try_snapshot(std::vector<T> &values) {
+  // The positions are passed to the MCAS as std::atomic<void *>, as they are
+  // to the descriptor functions, so that T may be an integer type.
+  typedef algorithms::wf::mcas::MultiWordCompareAndSwap<void *> MCAS;
+  // Positions read from consecutive addresses, the position after the last
+  // value holds no value.
+  struct Run {
+    std::atomic<T> *spot;
+    size_t first;
+    size_t length;
+  };
+  std::vector<Run> runs;
+  values.clear();
+
+  std::atomic<void *> control_address(nullptr);
+  tervel::tl_control_word = &control_address;
+
+  bool found_end = false;
+  size_t pos = 0;
+  while (!found_end) {
+    size_t length;
+    std::atomic<T> *spot = internal_array.get_chunk(pos, length, true);
+    if (spot == nullptr) {
+      // The segment has not been allocated, so it holds no values.
+#ifndef TERVEL_VECTOR_CONTIGUOUS
+      runs.push_back(Run{internal_array.get_spot(pos), pos, 1});
+#endif  // else the vector is full, no position after it may be written.
+      break;
+    }
+
+    size_t i = 0;
+    while (i < length && !found_end) {
+      T value = spot[i].load(std::memory_order_relaxed);
+      if (value != Vector<T>::c_not_value_ &&
+            !internal_array.is_valid(value)) {
+        // Another operation is in progress at this position, so the attempt
+        // fails once it is helped. at() is not used, as it may help
+        // announcements and this may run while helping one.
+        internal_array.is_descriptor(value, &(spot[i]));
+        return false;
+      }
+      if (value == Vector<T>::c_not_value_) {
+        found_end = true;
+      } else {
+        values.push_back(value);
+      }
+      i++;
+    }
+    runs.push_back(Run{spot, pos, i});
+    pos += length;
+  }
+
+  // Reading the positions again is far cheaper than placing a descriptor in
+  // each of them, so a change which has already happened fails the attempt
+  // here rather than in the MCAS.
+  for (size_t r = 0; r < runs.size(); r++) {
+    for (size_t i = 0; i < runs[r].length; i++) {
+      const size_t p = runs[r].first + i;
+      const T expected = p < values.size() ? values[p] :
+          Vector<T>::c_not_value_;
+      if (runs[r].spot[i].load(std::memory_order_relaxed) != expected) {
+        return false;
+      }
+    }
+  }
+
+  // MCAS keeps its rows in descending address order, so they are added in
+  // that order, which makes each addition constant time. The runs do not
+  // overlap, so only they need to be sorted.
+  std::sort(runs.begin(), runs.end(), [](const Run &a, const Run &b) {
+    return a.spot > b.spot;
+  });
+
+  assert(values.size() < INT_MAX);
+  MCAS *mcas = new MCAS(static_cast<int>(values.size() + 1));
+  for (size_t r = 0; r < runs.size(); r++) {
+    for (size_t i = runs[r].length; i-- > 0; ) {
+      const size_t p = runs[r].first + i;
+      void *value = reinterpret_cast<void *>(
+          p < values.size() ? values[p] : Vector<T>::c_not_value_);
+      bool added = mcas->add_cas_triple(
+          reinterpret_cast<std::atomic<void *> *>(&(runs[r].spot[i])),
+          value, value);
+      assert(added);
+      (void)added;
+    }
+  }
+  bool success = mcas->execute();
+  mcas->safe_delete();
+  return success;
+}  // try_snapshot
+
 }  // namespace vector
 }  // namespace wf
 }  // namespace containers
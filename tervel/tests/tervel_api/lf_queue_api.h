@@ -91,7 +91,7 @@ MACRO_OP_MAKER(0, { \
 ) \
 MACRO_OP_MAKER(1, { \
     /* Value value = random(); */ \
-    Value value = (thread_id << 56) | ecount; \
+    Value value = (thread_id << 56) | ecount++; \
     opRes = container->enqueue(value); \
   } \
 ) \
@@ -28,7 +28,12 @@
 #define DS_API_H_
 
 
+#include <stdlib.h>
+#include <unistd.h>
+
 #include <string>
+#include <utility>
+#include <vector>
 #include <tervel/containers/wf/hash-map/wf_hash_map.h>
 #include <tervel/util/info.h>
 #include <tervel/util/thread_context.h>
@@ -45,6 +50,8 @@ typedef typename container_t::ValueAccessor Accessor;
 DEFINE_int32(prefill, 0, "The number elements to place in the data structure on init.");
 DEFINE_int32(capacity, 32768, "The initial capacity of the hashmap, should be a power of two.");
 DEFINE_int32(expansion_factor, 5, "The size by which the hash map expands on collision. 2^x = positions, where x is the specified value.");
+DEFINE_int32(prefill_threads, 1, "The number of threads used to bulk load the prefill elements.");
+DEFINE_bool(compact_on_remove, true, "If true then removes collapse array nodes left holding one or fewer entries.");
 
 
 #define DS_DECLARE_CODE \
@@ -62,24 +69,39 @@ thread_context = new tervel::ThreadContext(tervel_obj);
 #define DS_INIT_CODE \
 tervel_obj = new tervel::Tervel(FLAGS_num_threads+1); \
 DS_ATTACH_THREAD \
-container = new container_t(FLAGS_capacity, FLAGS_expansion_factor); \
+container = new container_t(FLAGS_capacity, FLAGS_expansion_factor, \
+      FLAGS_compact_on_remove); \
 \
 std::default_random_engine generator; \
 std::uniform_int_distribution<Value> largeValue(0, UINT_MAX); \
+std::vector<std::pair<Key, Value>> prefill_elements; \
 for (int i = 0; i < FLAGS_prefill; i++) { \
   Value x = largeValue(generator) & (~0x3); \
-  container->insert(x, x); \
-}
+  prefill_elements.emplace_back(x, x); \
+} \
+container->bulk_load(prefill_elements.begin(), prefill_elements.end(), \
+      FLAGS_prefill_threads);
 
 #define DS_NAME "WF Hash Map"
 
 #define DS_CONFIG_STR \
     "\n" _DS_CONFIG_INDENT "Prefill : " + std::to_string(FLAGS_prefill) \
   + "\n" _DS_CONFIG_INDENT "Capacity : " + std::to_string(FLAGS_capacity) \
-  + "\n" _DS_CONFIG_INDENT "ExpansionFactor : " + std::to_string(FLAGS_expansion_factor) + "" + tervel_obj->get_config_str() + ""
+  + "\n" _DS_CONFIG_INDENT "ExpansionFactor : " + std::to_string(FLAGS_expansion_factor) \
+  + "\n" _DS_CONFIG_INDENT "CompactOnRemove : " + std::to_string(FLAGS_compact_on_remove) + "" + tervel_obj->get_config_str() + ""
 
 #define DS_STATE_STR \
-   "\n" _DS_CONFIG_INDENT "size : " + std::to_string(container->size()) + ""
+   "\n" _DS_CONFIG_INDENT "size : " + std::to_string(container->size()) \
+  + hashmap_statistics_str(container->statistics()) + ""
+
+inline std::string hashmap_statistics_str(const container_t::Statistics &stats) {
+  return "\n" _DS_CONFIG_INDENT "array_nodes : " + std::to_string(stats.array_nodes)
+    + "\n" _DS_CONFIG_INDENT "data_nodes : " + std::to_string(stats.data_nodes)
+    + "\n" _DS_CONFIG_INDENT "deleted_nodes : " + std::to_string(stats.deleted_nodes)
+    + "\n" _DS_CONFIG_INDENT "occupancy : " + std::to_string(stats.occupancy())
+    + "\n" _DS_CONFIG_INDENT "max_depth : " + std::to_string(stats.max_depth)
+    + "\n" _DS_CONFIG_INDENT "mean_depth : " + std::to_string(stats.mean_depth());
+}
 
 #define OP_RAND \
   std::uniform_int_distribution<Value> random(1, USHRT_MAX);
@@ -122,6 +144,130 @@ for (int i = 0; i < FLAGS_prefill; i++) { \
 
 #define DS_OP_COUNT 4
 
-inline void sanity_check(container_t *container) {};
+// Digests only the first byte of a key, so that keys starting with the same
+// byte collide.
+struct first_byte_functor
+    : tervel::containers::wf::string_functor<std::string, Value, 1> {
+  tervel::containers::wf::key_digest<1> hash(const std::string &k) {
+    return string_functor::hash(k.substr(0, 1));
+  }
+};
+
+inline void sanity_check(container_t *container) {
+  bool res;
+
+  // A snapshot loads into a map of another geometry with every key and value
+  // that was saved, and a map of another value type rejects it.
+  {
+    char path[] = "/tmp/tervel_hash_map_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0 && "If this assert fails then the snapshot file could not be created");
+    close(fd);
+
+    const Key count = 10000;
+    const Key stride = 0x9E3779B97F4A7C15LL;
+    container_t saved(64, 3);
+    for (Key i = 0; i < count; i++) {
+      saved.insert(i * stride, i * 3);
+    }
+    for (Key i = 0; i < count; i += 10) {
+      saved.remove(i * stride);
+    }
+    res = saved.save_snapshot(path);
+    assert(res && "If this assert fails then the snapshot could not be written");
+
+    container_t loaded(1024, 4);
+    res = loaded.load_snapshot(path, 4) && loaded.size() == saved.size();
+    assert(res && "If this assert fails then the snapshot did not load every key");
+    for (Key i = 0; i < count; i++) {
+      Accessor va;
+      res = loaded.at(i * stride, va) == (i % 10 != 0) &&
+          (i % 10 == 0 || *(va.value()) == i * 3);
+      assert(res && "If this assert fails then a key was loaded with the wrong value, or a removed key was loaded");
+    }
+
+    tervel::containers::wf::HashMap<Key, int32_t> narrow(64, 3);
+    res = !narrow.load_snapshot(path) && narrow.size() == 0;
+    assert(res && "If this assert fails then a snapshot of another value type was loaded");
+    unlink(path);
+  }
+
+  // Removes that do not compact leave the array nodes in place, and compact()
+  // then collapses all of them back into the primary array.
+  {
+    const Key count = 4096;
+    const Key stride = 0x9E3779B97F4A7C15LL;
+    container_t sparse(2, 2, false);
+    for (Key i = 0; i < count; i++) {
+      sparse.insert(i * stride, i);
+    }
+    res = sparse.statistics().array_nodes > 0;
+    assert(res && "If this assert fails then the keys did not expand the map");
+
+    for (Key i = 0; i < count; i++) {
+      sparse.remove(i * stride);
+    }
+    res = sparse.size() == 0 && sparse.statistics().array_nodes > 0;
+    assert(res && "If this assert fails then a remove compacted the map although compact_on_remove is false");
+
+    sparse.compact();
+    container_t::Statistics stats = sparse.statistics();
+    res = stats.array_nodes == 0 && stats.data_nodes == 0 &&
+        stats.deleted_nodes == 0 && stats.max_depth == 0;
+    assert(res && "If this assert fails then compact left array nodes or deleted data nodes in the map");
+  }
+
+  // Keys of any length are held by their digest and told apart by the keys
+  // themselves, including the empty key.
+  {
+    typedef tervel::containers::wf::HashMap<std::string, Value,
+        tervel::containers::wf::string_functor<std::string, Value> >
+        string_map_t;
+    string_map_t strings(64, 3);
+    const std::string keys[] = {"", "a", "ab", "abcdefgh", "abcdefghi",
+        std::string(100, 'x')};
+    const size_t count = sizeof(keys) / sizeof(keys[0]);
+
+    for (size_t i = 0; i < count; i++) {
+      res = strings.insert(keys[i], i) && !strings.insert(keys[i], i + 1);
+      assert(res && "If this assert fails then a string key was not inserted exactly once");
+    }
+    for (size_t i = 0; i < count; i++) {
+      string_map_t::ValueAccessor va;
+      res = strings.at(keys[i], va) && *(va.value()) == static_cast<Value>(i);
+      assert(res && "If this assert fails then a string key has the wrong value");
+    }
+    res = strings.remove("") && strings.remove("abcdefgh") &&
+        !strings.remove("abcdefgh") && strings.size() == count - 2;
+    assert(res && "If this assert fails then a string key was not removed exactly once");
+    for (size_t i = 0; i < count; i++) {
+      string_map_t::ValueAccessor va;
+      res = strings.at(keys[i], va) == (keys[i] != "" && keys[i] != "abcdefgh");
+      assert(res && "If this assert fails then a removed string key was found, or a remaining one was lost");
+    }
+    res = strings.insert("", 7);
+    assert(res && "If this assert fails then a removed string key could not be inserted again");
+  }
+
+  // A key whose digest matches that of a held key is not inserted, and does
+  // not match the held key.
+  {
+    typedef tervel::containers::wf::HashMap<std::string, Value,
+        first_byte_functor> colliding_map_t;
+    colliding_map_t colliding(64, 3);
+    res = colliding.insert("apple", 1) && !colliding.insert("avocado", 2) &&
+        colliding.insert("banana", 3);
+    assert(res && "If this assert fails then a key with a colliding digest was inserted");
+    colliding_map_t::ValueAccessor va;
+    res = !colliding.at("avocado", va) && !colliding.remove("avocado");
+    assert(res && "If this assert fails then a key matched a different key with the same digest");
+    colliding_map_t::ValueAccessor va2;
+    res = colliding.at("apple", va2) && *(va2.value()) == 1;
+    assert(res && "If this assert fails then a colliding insert changed the held key");
+  }
+
+  (void)res;
+  (void)container;
+};
 
 #endif  // DS_API_H_
@@ -0,0 +1,164 @@
+/*
+#The MIT License (MIT)
+#
+#Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+#Scalable & Secure Systems (CSE - S3) Lab
+#
+#Permission is hereby granted, free of charge, to any person obtaining a copy
+#of this software and associated documentation files (the "Software"), to deal
+#in the Software without restriction, including without limitation the rights
+#to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+#copies of the Software, and to permit persons to whom the Software is
+#furnished to do so, subject to the following conditions:
+#
+#The above copyright notice and this permission notice shall be included in
+#all copies or substantial portions of the Software.
+#
+#THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+#OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+#THE SOFTWARE.
+#
+*/
+
+#ifndef DS_API_H_
+#define DS_API_H_
+
+#include <string>
+#include <tervel/containers/wf/vector/payload_vector.h>
+#include <tervel/util/info.h>
+#include <tervel/util/thread_context.h>
+#include <tervel/util/tervel.h>
+
+typedef uint64_t Value;
+typedef tervel::containers::wf::vector::PayloadVector<Value> container_t;
+
+
+#include "../src/main.h"
+
+DEFINE_int32(capacity, 64, "The initial size of the vector");
+DEFINE_int32(prefill, 0, "The number elements to prefill the vector with.");
+
+#define DS_DECLARE_CODE \
+  tervel::Tervel* tervel_obj; \
+  container_t *container;
+
+#define DS_DESTORY_CODE
+
+#define DS_ATTACH_THREAD \
+tervel::ThreadContext* thread_context __attribute__((unused)); \
+thread_context = new tervel::ThreadContext(tervel_obj);
+
+#define DS_DETACH_THREAD
+
+#define DS_INIT_CODE \
+tervel_obj = new tervel::Tervel(FLAGS_num_threads+1); \
+DS_ATTACH_THREAD \
+container = new container_t(FLAGS_capacity); \
+\
+std::default_random_engine generator; \
+std::uniform_int_distribution<Value> largeValue; \
+for (int i = 0; i < FLAGS_prefill; i++) { \
+  container->push_back(largeValue(generator)); \
+}
+
+#define DS_NAME "WF Payload Vector"
+
+
+#define DS_STATE_STR \
+   "\n" _DS_CONFIG_INDENT "size : " + std::to_string(container->size()) + ""
+
+#define DS_CONFIG_STR \
+   "\n" _DS_CONFIG_INDENT "Prefill : " + std::to_string(FLAGS_prefill) +"" + \
+   "\n" _DS_CONFIG_INDENT "Capacity : " + std::to_string(FLAGS_capacity) +"" + tervel_obj->get_config_str() + DS_STATE_STR
+
+#define OP_RAND \
+  std::uniform_int_distribution<uint64_t> random(0, UINT_MAX);
+
+#define OP_CODE \
+  MACRO_OP_MAKER(0, { \
+      size_t s = container->size(); \
+      if (s == 0) { \
+        opRes = false; \
+      } else { \
+        size_t idx = random(generator) % s;\
+        Value value; \
+        opRes = container->at(idx, value); \
+      }\
+    } \
+  ) \
+  MACRO_OP_MAKER(1, { \
+      size_t s = container->size(); \
+      if (s == 0) { \
+        opRes = false; \
+      } else { \
+        size_t idx = random(generator) % s;\
+        Value old_value; \
+        if (!container->at(idx, old_value)) { \
+          opRes = false; \
+        } else { \
+          opRes = container->cas(idx, old_value, old_value + 1); \
+        } \
+      }\
+    } \
+  ) \
+  MACRO_OP_MAKER(2, { \
+      size_t s = container->size(); \
+      if (s == 0) { \
+        opRes = false; \
+      } else { \
+        size_t idx = random(generator) % s;\
+        Value prior; \
+        opRes = container->fetch_add(idx, 1, prior); \
+      }\
+    } \
+  ) \
+  MACRO_OP_MAKER(3, { \
+      Value temp = static_cast<Value>(thread_id) << 56 | lcount; \
+      container->push_back(temp); \
+      opRes = true; \
+    } \
+  ) \
+  MACRO_OP_MAKER(4, { \
+      container->size(); \
+    } \
+  )
+
+#define DS_OP_NAMES "at", "cas", "fetchAdd", "pushBack", "size"
+
+#define DS_OP_COUNT 5
+
+inline void sanity_check(container_t *container) {
+  // Values with the low bits set and zero are stored unchanged.
+  const Value values[] = {0, 1, 2, 3, ~Value(0), Value(1) << 63};
+  const size_t count = sizeof(values) / sizeof(values[0]);
+
+  const size_t first = container->size();
+  for (size_t i = 0; i < count; i++) {
+    size_t pos = container->push_back(values[i]);
+    assert(pos == first + i && "If this assert fails then there is an issue with reserving positions");
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    Value value;
+    bool res = container->at(first + i, value);
+    assert(res && value == values[i] && "If this assert fails then a value was not stored unchanged");
+
+    Value expected = values[i];
+    res = container->cas(first + i, expected, values[i] + 1);
+    assert(res && "If this assert fails then there is an issue with cas");
+
+    res = container->fetch_add(first + i, 1, value);
+    assert(res && value == values[i] + 1 && "If this assert fails then there is an issue with fetch_add");
+  }
+
+  Value value;
+  bool res = container->at(first + count, value);
+  assert(!res && "If this assert fails then a position without a value was read");
+  (void)res;
+};
+
+#endif  // DS_API_H_
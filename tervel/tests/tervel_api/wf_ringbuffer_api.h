@@ -29,6 +29,7 @@
 
 
 #include <string>
+#include <vector>
 #include <tervel/util/info.h>
 #include <tervel/util/thread_context.h>
 #include <tervel/util/tervel.h>
@@ -61,6 +62,7 @@ class WrapperType : public container_t::Value {
 
 DEFINE_int32(prefill, 0, "The number elements to place in the buffer on init.");
 DEFINE_int32(capacity, 32768, "The capacity of the buffer.");
+DEFINE_int32(bulk_size, 1, "If greater than 1, each operation enqueues or dequeues this many elements using enqueue_bulk and dequeue_bulk.");
 
 #define DS_DECLARE_CODE \
   tervel::Tervel* tervel_obj; \
@@ -90,13 +92,15 @@ for (int i = 0; i < FLAGS_prefill; i++) { \
 
 #define DS_CONFIG_STR \
    "\n" _DS_CONFIG_INDENT "prefill : " + std::to_string(FLAGS_prefill) +"" + \
-   "\n" _DS_CONFIG_INDENT "capacity : " + std::to_string(FLAGS_capacity) +"" + tervel_obj->get_config_str() + ""
+   "\n" _DS_CONFIG_INDENT "capacity : " + std::to_string(FLAGS_capacity) +"" + \
+   "\n" _DS_CONFIG_INDENT "bulk_size : " + std::to_string(FLAGS_bulk_size) +"" + tervel_obj->get_config_str() + ""
 
 #define DS_STATE_STR " "
 
 #define OP_RAND \
   /* std::uniform_int_distribution<Value_o> random(1, UINT_MAX); */ \
-  int ecount = 0;
+  int ecount = 0; \
+  std::vector<WrapperType *> bulk(FLAGS_bulk_size);
 
 
 #define OP_CODE \
@@ -104,13 +108,28 @@ for (int i = 0; i < FLAGS_prefill; i++) { \
     /* Value_o value = random(); */ \
     Value_o value = ecount++;\
     if (ecount == 0) ecount++; \
-    WrapperType *temp = new WrapperType(value); \
-    opRes = container->enqueue(temp); \
+    if (FLAGS_bulk_size > 1) { \
+      for (int i = 0; i < FLAGS_bulk_size; i++) { \
+        bulk[i] = new WrapperType(value); \
+      } \
+      size_t count = container->enqueue_bulk(bulk.data(), FLAGS_bulk_size); \
+      for (int i = count; i < FLAGS_bulk_size; i++) { \
+        delete bulk[i]; \
+      } \
+      opRes = (count != 0); \
+    } else { \
+      WrapperType *temp = new WrapperType(value); \
+      opRes = container->enqueue(temp); \
+    } \
   } \
   ) \
  MACRO_OP_MAKER(1, { \
-      WrapperType *value; \
-      opRes = container->dequeue(value); \
+      if (FLAGS_bulk_size > 1) { \
+        opRes = (container->dequeue_bulk(bulk.data(), FLAGS_bulk_size) != 0); \
+      } else { \
+        WrapperType *value; \
+        opRes = container->dequeue(value); \
+      } \
     } \
   )
 
@@ -0,0 +1,193 @@
+/*
+#The MIT License (MIT)
+#
+#Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+#Scalable & Secure Systems (CSE - S3) Lab
+#
+#Permission is hereby granted, free of charge, to any person obtaining a copy
+#of this software and associated documentation files (the "Software"), to deal
+#in the Software without restriction, including without limitation the rights
+#to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+#copies of the Software, and to permit persons to whom the Software is
+#furnished to do so, subject to the following conditions:
+#
+#The above copyright notice and this permission notice shall be included in
+#all copies or substantial portions of the Software.
+#
+#THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+#OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+#THE SOFTWARE.
+#
+*/
+
+#ifndef DS_API_H_
+#define DS_API_H_
+
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <tervel/util/info.h>
+#include <tervel/util/thread_context.h>
+#include <tervel/util/tervel.h>
+
+#include <tervel/containers/wf/ring-buffer/ring_buffer.h>
+
+
+typedef uint32_t Value_o;
+
+typedef tervel::containers::wf::RingBuffer<Value_o> container_t;
+
+
+#include "../src/main.h"
+
+DEFINE_int32(prefill, 0, "The number elements to place in the buffer on init.");
+DEFINE_int32(capacity, 32768, "The capacity of the buffer.");
+DEFINE_int32(bulk_size, 1, "If greater than 1, each operation enqueues or dequeues this many elements using enqueue_bulk and dequeue_bulk.");
+
+#define DS_DECLARE_CODE \
+  tervel::Tervel* tervel_obj; \
+  container_t *container;
+
+#define DS_DESTORY_CODE
+
+#define DS_ATTACH_THREAD \
+tervel::ThreadContext* thread_context __attribute__((unused)); \
+thread_context = new tervel::ThreadContext(tervel_obj);
+
+#define DS_DETACH_THREAD
+
+#define DS_INIT_CODE \
+tervel_obj = new tervel::Tervel(FLAGS_num_threads+1); \
+DS_ATTACH_THREAD \
+container = new container_t(FLAGS_capacity); \
+\
+for (int i = 0; i < FLAGS_prefill; i++) { \
+  container->enqueue(static_cast<Value_o>(i)); \
+} \
+
+#define DS_NAME "WF Ring Buffer (integral values)"
+
+#define DS_CONFIG_STR \
+   "\n" _DS_CONFIG_INDENT "prefill : " + std::to_string(FLAGS_prefill) +"" + \
+   "\n" _DS_CONFIG_INDENT "capacity : " + std::to_string(FLAGS_capacity) +"" + \
+   "\n" _DS_CONFIG_INDENT "bulk_size : " + std::to_string(FLAGS_bulk_size) +"" + tervel_obj->get_config_str() + ""
+
+#define DS_STATE_STR " "
+
+#define OP_RAND \
+  /* std::uniform_int_distribution<Value_o> random(1, UINT_MAX); */ \
+  int ecount = 0; \
+  std::vector<Value_o> bulk(FLAGS_bulk_size);
+
+
+#define OP_CODE \
+  MACRO_OP_MAKER(0, { \
+    /* Value_o value = random(); */ \
+    Value_o value = ecount++;\
+    if (ecount == 0) ecount++; \
+    if (FLAGS_bulk_size > 1) { \
+      for (int i = 0; i < FLAGS_bulk_size; i++) { \
+        bulk[i] = value; \
+      } \
+      size_t count = container->enqueue_bulk(bulk.data(), FLAGS_bulk_size); \
+      opRes = (count != 0); \
+    } else { \
+      opRes = container->enqueue(value); \
+    } \
+  } \
+  ) \
+ MACRO_OP_MAKER(1, { \
+      if (FLAGS_bulk_size > 1) { \
+        opRes = (container->dequeue_bulk(bulk.data(), FLAGS_bulk_size) != 0); \
+      } else { \
+        Value_o value; \
+        opRes = container->dequeue(value); \
+      } \
+    } \
+  )
+
+#define DS_OP_NAMES "enqueue", "dequeue"
+
+#define DS_OP_COUNT 2
+
+
+inline void sanity_check(container_t *container) {
+  // Producers and consumers move batches through a small buffer with
+  // enqueue_bulk and dequeue_bulk, so that their ranges race and wrap. Each
+  // value must be dequeued exactly once.
+  const int producers = 2;
+  const int consumers = 4;
+  const Value_o per_producer = 100000;
+  const size_t batch = 8;
+  const Value_o total = producers * per_producer;
+
+  container_t buffer(64);
+  // Like the benchmark's, this Tervel object is never destroyed.
+  tervel::Tervel *test_obj = new tervel::Tervel(producers + consumers);
+  std::vector<std::atomic<int>> seen(total);
+  for (Value_o i = 0; i < total; i++) {
+    seen[i].store(0);
+  }
+  std::atomic<Value_o> dequeued(0);
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&, p]() {
+      tervel::ThreadContext context(test_obj);
+      Value_o next = p * per_producer;
+      const Value_o end = next + per_producer;
+      Value_o values[batch];
+      while (next < end) {
+        size_t n = std::min<size_t>(batch, end - next);
+        for (size_t i = 0; i < n; i++) {
+          values[i] = next + i;
+        }
+        n = buffer.enqueue_bulk(values, n);
+        if (n == 0) {
+          std::this_thread::yield();
+        }
+        next += n;
+      }
+    });
+  }
+  for (int c = 0; c < consumers; c++) {
+    threads.emplace_back([&]() {
+      tervel::ThreadContext context(test_obj);
+      Value_o values[batch];
+      while (dequeued.load() < total) {
+        size_t n = buffer.dequeue_bulk(values, batch);
+        if (n == 0) {
+          std::this_thread::yield();
+        }
+        for (size_t i = 0; i < n; i++) {
+          assert(values[i] < total && "If this assert fails then a value was corrupted");
+          seen[values[i]].fetch_add(1);
+        }
+        dequeued.fetch_add(n);
+      }
+    });
+  }
+  for (size_t i = 0; i < threads.size(); i++) {
+    threads[i].join();
+  }
+
+  assert(dequeued.load() == total && "If this assert fails then more values were dequeued than enqueued");
+  for (Value_o i = 0; i < total; i++) {
+    assert(seen[i].load() == 1 && "If this assert fails then a value was lost or dequeued twice");
+  }
+  Value_o value;
+  bool res = !buffer.dequeue(value);
+  assert(res && "If this assert fails then a value was left in the buffer");
+  (void)res;
+  (void)container;
+};
+
+#endif  // DS_API_H_
+
@@ -0,0 +1,233 @@
+/*
+#The MIT License (MIT)
+#
+#Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+#Scalable & Secure Systems (CSE - S3) Lab
+#
+#Permission is hereby granted, free of charge, to any person obtaining a copy
+#of this software and associated documentation files (the "Software"), to deal
+#in the Software without restriction, including without limitation the rights
+#to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+#copies of the Software, and to permit persons to whom the Software is
+#furnished to do so, subject to the following conditions:
+#
+#The above copyright notice and this permission notice shall be included in
+#all copies or substantial portions of the Software.
+#
+#THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+#OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+#THE SOFTWARE.
+#
+*/
+
+#ifndef DS_API_H_
+#define DS_API_H_
+
+#include <string>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <tervel/util/info.h>
+#include <tervel/util/thread_context.h>
+#include <tervel/util/tervel.h>
+
+#include <tervel/containers/wf/ring-buffer/shared_ring_buffer.h>
+
+
+typedef uint32_t Value_o;
+
+typedef tervel::containers::wf::SharedRingBuffer<Value_o> container_t;
+
+
+#include "../src/main.h"
+
+DEFINE_int32(prefill, 0, "The number elements to place in the buffer on init.");
+DEFINE_int32(capacity, 32768, "The capacity of the buffer.");
+
+// The buffer is created in a memfd, the threads share this process's mapping
+// of it.
+#define DS_DECLARE_CODE \
+  tervel::Tervel* tervel_obj; \
+  container_t *container; \
+  int container_fd;
+
+#define DS_DESTORY_CODE \
+  container->detach(); \
+  close(container_fd);
+
+#define DS_ATTACH_THREAD \
+tervel::ThreadContext* thread_context __attribute__((unused)); \
+thread_context = new tervel::ThreadContext(tervel_obj);
+
+#define DS_DETACH_THREAD
+
+#define DS_INIT_CODE \
+tervel_obj = new tervel::Tervel(FLAGS_num_threads+1); \
+container_fd = memfd_create("tervel_shared_ring_buffer", 0); \
+container = container_t::create(container_fd, FLAGS_capacity); \
+assert(container != nullptr); \
+\
+for (int i = 0; i < FLAGS_prefill; i++) { \
+  container->enqueue(static_cast<Value_o>(i)); \
+} \
+
+#define DS_NAME "LF Shared Ring Buffer"
+
+#define DS_CONFIG_STR \
+   "\n" _DS_CONFIG_INDENT "prefill : " + std::to_string(FLAGS_prefill) +"" + \
+   "\n" _DS_CONFIG_INDENT "capacity : " + std::to_string(FLAGS_capacity) +"" + tervel_obj->get_config_str() + ""
+
+#define DS_STATE_STR \
+   "\n" _DS_CONFIG_INDENT "attached : " + std::to_string(container->attached()) + ""
+
+#define OP_RAND \
+  int ecount = 0;
+
+#define OP_CODE \
+  MACRO_OP_MAKER(0, { \
+    Value_o value = ecount++;\
+    opRes = container->enqueue(value); \
+  } \
+  ) \
+ MACRO_OP_MAKER(1, { \
+      Value_o value; \
+      opRes = container->dequeue(value); \
+    } \
+  )
+
+#define DS_OP_NAMES "enqueue", "dequeue"
+
+#define DS_OP_COUNT 2
+
+
+// Runs fn in a child process, which attaches to the buffer in fd.
+// @return the child's pid.
+template<typename Function>
+inline pid_t shared_buffer_child(int fd, Function fn) {
+  pid_t pid = fork();
+  assert(pid >= 0 && "If this assert fails then the child process could not be started");
+  if (pid == 0) {
+    container_t *buffer = container_t::attach(fd);
+    if (buffer == nullptr) {
+      _exit(1);
+    }
+    fn(buffer);
+    buffer->detach();
+    _exit(0);
+  }
+  return pid;
+}
+
+inline void sanity_check(container_t *container) {
+  const Value_o limit = 1000;
+  int status;
+
+  for (Value_o i = 0; i < limit; i++) {
+    bool res = container->enqueue(i);
+    assert(res && "If this assert fails then there is an issue with either enqueueing or determining that it is full");
+  }
+  for (Value_o i = 0; i < limit; i++) {
+    Value_o temp;
+    bool res = container->dequeue(temp);
+    assert(res && temp == i && "If this assert fails then there is an issue with dequeueing in FIFO order");
+  }
+
+  {
+    // A buffer which is not initialised, or was created for another T, is
+    // not attached to.
+    int other_fd = memfd_create("tervel_shared_ring_buffer_check", 0);
+    assert(container_t::attach(other_fd) == nullptr && "If this assert fails then an empty file was attached to");
+    typedef tervel::containers::wf::SharedRingBuffer<uint16_t> other_t;
+    other_t *other = other_t::create(other_fd, 16);
+    assert(other != nullptr);
+    assert(container_t::attach(other_fd) == nullptr && "If this assert fails then a buffer of another type was attached to");
+    other->detach();
+    close(other_fd);
+  }
+
+  // Values enqueued by another process are dequeued in order, and its
+  // attach and detach are counted. The buffer is created in a new memfd as
+  // the container's is not visible here.
+  int fd = memfd_create("tervel_shared_ring_buffer_check", 0);
+  container_t *shared = container_t::create(fd, limit);
+  assert(shared != nullptr);
+  pid_t pid = shared_buffer_child(fd, [&](container_t *buffer) {
+    if (buffer->attached() != 2) {
+      _exit(2);
+    }
+    for (Value_o i = 0; i < limit; i++) {
+      if (!buffer->enqueue(i)) {
+        _exit(3);
+      }
+    }
+  });
+  waitpid(pid, &status, 0);
+  assert(WIFEXITED(status) && WEXITSTATUS(status) == 0 && "If this assert fails then the child could not attach or enqueue");
+  assert(shared->attached() == 1 && "If this assert fails then the child's detach was not counted");
+  for (Value_o i = 0; i < limit; i++) {
+    Value_o temp;
+    bool res = shared->dequeue(temp);
+    assert(res && temp == i && "If this assert fails then values enqueued by another process were lost or reordered");
+  }
+  shared->detach();
+  close(fd);
+
+  // A process killed at an arbitrary point of an enqueue or dequeue must not
+  // stop the buffer: at most the value it was dequeueing is delivered late,
+  // and every value enqueued afterwards is dequeued once, in order.
+  const int64_t capacity = 8;
+  const Value_o marker = Value_o(1) << 31;
+  for (int round = 0; round < 20; round++) {
+    fd = memfd_create("tervel_shared_ring_buffer_check", 0);
+    container_t *buffer = container_t::create(fd, capacity);
+    assert(buffer != nullptr);
+
+    pid = shared_buffer_child(fd, [&](container_t *child_buffer) {
+      for (Value_o i = 0; true; i = (i + 1) % marker) {
+        Value_o temp;
+        child_buffer->enqueue(i);
+        child_buffer->dequeue(temp);
+      }
+    });
+    usleep(1000 * (1 + round % 5));
+    kill(pid, SIGKILL);
+    waitpid(pid, &status, 0);
+    assert(buffer->attached() == 2 && "If this assert fails then a killed process was counted as detached");
+
+    Value_o temp;
+    while (buffer->dequeue(temp)) {}
+
+    Value_o expected = 0;
+    int late = 0;
+    for (Value_o i = 0; i < 8 * capacity; i++) {
+      bool res = buffer->enqueue(marker | i);
+      assert(res && "If this assert fails then the killed process left the buffer unable to enqueue");
+      if (buffer->dequeue(temp)) {
+        if (temp & marker) {
+          assert(temp == (marker | expected++) && "If this assert fails then values were lost or reordered after a process was killed");
+        } else {
+          late++;
+        }
+      }
+    }
+    while (buffer->dequeue(temp)) {
+      if (temp & marker) {
+        assert(temp == (marker | expected++) && "If this assert fails then values were lost or reordered after a process was killed");
+      } else {
+        late++;
+      }
+    }
+    assert(expected == 8 * capacity && "If this assert fails then values were lost after a process was killed");
+    assert(late <= 1 && "If this assert fails then more than the killed consumer's value was delivered late");
+
+    buffer->detach();
+    close(fd);
+  }
+};
+
+#endif  // DS_API_H_
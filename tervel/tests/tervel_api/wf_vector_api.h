@@ -40,7 +40,12 @@ typedef tervel::containers::wf::vector::Vector<Value> container_t;
 
 #include "../src/main.h"
 
+#ifdef TERVEL_VECTOR_CONTIGUOUS
+// The array does not grow, so by default it holds a long push only run.
+DEFINE_int32(capacity, 1 << 26, "The most values the vector holds");
+#else
 DEFINE_int32(capacity, 0, "The initial size of the vector");
+#endif
 DEFINE_int32(prefill, 0, "The number elements to prefill the vector with.");
 
 #define DS_DECLARE_CODE \
@@ -58,12 +63,13 @@ thread_context = new tervel::ThreadContext(tervel_obj);
 #define DS_INIT_CODE \
 tervel_obj = new tervel::Tervel(FLAGS_num_threads+1); \
 DS_ATTACH_THREAD \
-container = new container_t(); \
+container = FLAGS_capacity > 0 ? new container_t(FLAGS_capacity) \
+                              : new container_t(); \
 \
 std::default_random_engine generator; \
 std::uniform_int_distribution<Value> largeValue(0, UINT_MAX); \
 for (int i = 0; i < FLAGS_prefill; i++) { \
-  Value x = largeValue(generator) & (~0x3); \
+  Value x = (largeValue(generator) & (~0x3)) | 0x4; \
   container->push_back(x); \
 }
 
@@ -89,7 +95,7 @@ for (int i = 0; i < FLAGS_prefill; i++) { \
       if (s == 0) { \
         opRes = false; \
       } else { \
-        int idx = random(generator) % s;\
+        size_t idx = random(generator) % s;\
         Value value; \
         opRes = container->at(idx, value); \
       }\
@@ -100,13 +106,12 @@ for (int i = 0; i < FLAGS_prefill; i++) { \
       if (s == 0) { \
         opRes = false; \
       } else { \
-        int idx = random(generator) % s;\
+        size_t idx = random(generator) % s;\
         Value old_value; \
-        container->at(idx, old_value); \
-        if (old_value & uint64_t(0x3) != uint64_t(0)) { \
+        if (!container->at(idx, old_value)) { \
           opRes = false; \
         } else { \
-          Value new_value = new_value*2; \
+          Value new_value = old_value + 4; \
           opRes = container->cas(idx, old_value, new_value); \
         } \
       }\
@@ -115,8 +120,8 @@ for (int i = 0; i < FLAGS_prefill; i++) { \
   MACRO_OP_MAKER(2, { \
       Value temp = reinterpret_cast<Value>(thread_id); \
       temp = temp << (sizeof(Value)*8-7); \
-      temp = temp | (lcount << 3); \
-      opRes = container->push_back(temp); \
+      temp = temp | (lcount << 3) | 0x4; \
+      opRes = container->push_back(temp) != static_cast<size_t>(-1); \
     } \
   ) \
   MACRO_OP_MAKER(3, { \
@@ -133,7 +138,7 @@ for (int i = 0; i < FLAGS_prefill; i++) { \
     if (s == 0) { \
       opRes = false; \
     } else { \
-      int idx = random(generator) % s; \
+      size_t idx = random(generator) % s; \
       Value value = -1; \
       opRes = container->eraseAt(idx, value); \
     } \
@@ -144,10 +149,10 @@ for (int i = 0; i < FLAGS_prefill; i++) { \
     if (s == 0) { \
       opRes = false; \
     } else { \
-      int idx = random(generator) % s; \
+      size_t idx = random(generator) % s; \
       Value temp = reinterpret_cast<Value>(thread_id); \
       temp = temp << (sizeof(Value)*8-7); \
-      temp = temp | (lcount << 3); \
+      temp = temp | (lcount << 3) | 0x4; \
       opRes = container->insertAt(idx, temp); \
     } \
   }\
@@ -157,6 +162,102 @@ for (int i = 0; i < FLAGS_prefill; i++) { \
 
 #define DS_OP_COUNT 7
 
-inline void sanity_check(container_t *container) {};
+inline void sanity_check(container_t *container) {
+  typedef tervel::containers::wf::vector::ArrayArray<Value> array_t;
+
+  // Checks the segment math on both sides of every segment boundary, which
+  // covers positions beyond 2^32 without allocating them.
+  for (size_t offset_pow = 1; offset_pow <= 16; offset_pow += 5) {
+    const size_t offset = size_t(1) << offset_pow;
+    size_t seg_num, elem_pos;
+
+    array_t::locate(0, offset_pow, seg_num, elem_pos);
+    assert(seg_num == 0 && elem_pos == 0 && "If this assert fails then the first position is not at the start of the first segment");
+
+    for (size_t seg = 1; offset_pow + seg < 64; seg++) {
+      const size_t start = array_t::segment_capacity(seg, offset_pow) - offset;
+      const size_t prev_cap = array_t::segment_capacity(seg - 1, offset_pow);
+
+      array_t::locate(start - 1, offset_pow, seg_num, elem_pos);
+      assert(seg_num == seg - 1 && elem_pos == prev_cap - 1 && "If this assert fails then the last position of a segment is misplaced");
+
+      array_t::locate(start, offset_pow, seg_num, elem_pos);
+      assert(seg_num == seg && elem_pos == 0 && "If this assert fails then the first position of a segment is misplaced");
+
+      array_t::locate(start + prev_cap / 2, offset_pow, seg_num, elem_pos);
+      assert(seg_num == seg && elem_pos == prev_cap / 2 && "If this assert fails then a position within a segment is misplaced");
+    }
+  }
+
+  // Positions beyond 2^32 can be written and read back. Only the pages
+  // touched in their segment are faulted in.
+  {
+    array_t positions(2, 0);
+    const size_t base = size_t(1) << 32;
+    const size_t ks[] = {0, 1, 12345, base - 3};
+    for (size_t i = 0; i < 4; i++) {
+      positions.get_spot(base + ks[i])->store((ks[i] << 3) | 0x4);
+    }
+    positions.get_spot(7)->store(0x4);
+    for (size_t i = 0; i < 4; i++) {
+      std::atomic<Value> *spot = positions.get_spot(base + ks[i], true);
+      assert(spot != nullptr && spot->load() == ((ks[i] << 3) | 0x4) && "If this assert fails then a position beyond 2^32 did not hold its value");
+      (void)spot;
+    }
+    assert(positions.get_spot(7, true)->load() == 0x4 && "If this assert fails then a position beyond 2^32 overlapped the first segment");
+  }
+
+  // snapshot copies the values in order and sees a change made before it,
+  // both when an attempt succeeds and when it is announced.
+  std::vector<Value> copy;
+  container->snapshot(copy);
+  const size_t size = container->size();
+  assert(copy.size() == size && "If this assert fails then snapshot did not copy every value");
+  for (size_t i = 0; i < size; i++) {
+    Value value;
+    bool res = container->at(i, value);
+    assert(res && value == copy[i] && "If this assert fails then snapshot copied a value to the wrong position");
+  }
+
+  const Value extra = (size + 1) << 3;
+  container->push_back(extra);
+  typedef tervel::containers::wf::vector::SnapshotOp<Value> snapshot_op_t;
+  snapshot_op_t *op = new snapshot_op_t(container);
+  tervel::util::ProgressAssurance::make_announcement(
+        reinterpret_cast<tervel::util::OpRecord *>(op));
+  op->result(copy);
+  op->safe_delete();
+  assert(copy.size() == size + 1 && copy.back() == extra && "If this assert fails then an announced snapshot missed a value");
+
+  Value temp;
+  container->pop_back(temp);
+  bool res = container->try_snapshot(copy);
+  assert(res && copy.size() == size && "If this assert fails then an attempt failed on an unchanged vector");
+  (void)res;
+
+#ifdef TERVEL_VECTOR_CONTIGUOUS
+  // Pushes and inserts past the capacity fail and leave the values as they
+  // were, and a pop makes room again.
+  {
+    container_t full(4);
+    const Value values[] = {0x4, 0x8, 0xc, 0x10};
+    for (size_t i = 0; i < 4; i++) {
+      res = full.push_back(values[i]) == i;
+      assert(res && "If this assert fails then a push within the capacity failed");
+    }
+    res = full.push_back(0x14) == static_cast<size_t>(-1) &&
+        full.push_back_w_ra(0x14) == static_cast<size_t>(-1) &&
+        !full.insertAt(1, 0x14) && full.size() == 4;
+    assert(res && "If this assert fails then a push or insert exceeded the capacity");
+    res = full.pop_back(temp) && temp == values[3] && full.insertAt(1, 0x14);
+    assert(res && "If this assert fails then a pop did not make room");
+    for (size_t i = 0; i < 4; i++) {
+      const Value expected[] = {0x4, 0x14, 0x8, 0xc};
+      res = full.at(i, temp) && temp == expected[i];
+      assert(res && "If this assert fails then an insert in a full vector moved a value");
+    }
+  }
+#endif  // TERVEL_VECTOR_CONTIGUOUS
+};
 
 #endif  // DS_API_H_
@@ -0,0 +1,172 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef TERVEL_UTIL_ELIMINATION_ARRAY_H_
+#define TERVEL_UTIL_ELIMINATION_ARRAY_H_
+
+#include <atomic>
+#include <memory>
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <tervel/util/info.h>
+#include <tervel/util/system.h>
+#include <tervel/util/util.h>
+
+namespace tervel {
+namespace util {
+
+/**
+ * Lets a push and a pop which run at the same time exchange a value without
+ * updating the stack, as the two cancel out. A stack uses it after failing
+ * to update its head, so that under contention pairs of operations complete
+ * without touching the head at all.
+ *
+ * A push offers its value in a slot and waits up to
+ * TERVEL_ELIMINATION_SPIN loads for a pop to take it, a pop only takes
+ * values already offered and never waits. A slot's state holds a sequence
+ * number which every exchange advances, so a push withdrawing its offer
+ * cannot mistake a later offer for its own, and a thread stalled in a slot
+ * only keeps other threads from using that slot.
+ *
+ * The number of slots used adapts between one and the array's width: it
+ * doubles when a push finds its slot in use and halves when an offer times
+ * out.
+ *
+ * @tparam T the type of the values exchanged
+ */
+template<typename T>
+class EliminationArray {
+ public:
+  explicit EliminationArray(size_t width = TERVEL_ELIMINATION_WIDTH)
+    : width_(width < 1 ? 1 : width)
+    , slots_(new Slot[width_]) {}
+
+  /**
+   * Offers value to a pop.
+   * @return whether a pop took the value, in which case both operations are
+   * complete.
+   */
+  bool offer(const T &value) {
+    const size_t active = active_.load(std::memory_order_relaxed);
+    Slot &slot = slots_[thread_slot(active)];
+
+    uint64_t empty = slot.state.load();
+    if ((empty & k_phase_mask) != k_empty ||
+          !slot.state.compare_exchange_strong(empty, empty | k_claimed)) {
+      // Another push is using the slot.
+      if (active < width_) {
+        active_.store(active * 2 > width_ ? width_ : active * 2,
+            std::memory_order_relaxed);
+      }
+      return false;
+    }
+
+    slot.value = value;
+    const uint64_t offered = empty | k_offered;
+    slot.state.store(offered);
+
+    for (int i = 0; i < TERVEL_ELIMINATION_SPIN; i++) {
+      if (slot.state.load(std::memory_order_relaxed) != offered) {
+        break;
+      }
+    }
+
+    uint64_t expected = offered;
+    if (slot.state.compare_exchange_strong(expected, next_empty(empty))) {
+      // No pop came.
+      if (active > 1) {
+        active_.store(active / 2, std::memory_order_relaxed);
+      }
+      return false;
+    }
+    // A pop took the value, it frees the slot.
+    return true;
+  }
+
+  /**
+   * Takes a value offered by a push, checking each slot in use once.
+   * @return whether a value was taken, in which case both operations are
+   * complete.
+   */
+  bool take(T &value) {
+    const size_t active = active_.load(std::memory_order_relaxed);
+    const size_t start = thread_slot(active);
+
+    for (size_t i = 0; i < active; i++) {
+      Slot &slot = slots_[(start + i) % active];
+      uint64_t offered = slot.state.load();
+      if ((offered & k_phase_mask) == k_offered &&
+            slot.state.compare_exchange_strong(offered,
+              (offered & ~k_phase_mask) | k_taken)) {
+        value = slot.value;
+        slot.state.store(next_empty(offered));
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  // A slot's state is its sequence number shifted left by two, or'ed with
+  // its phase.
+  static const uint64_t k_phase_mask = 0x3;
+  static const uint64_t k_empty = 0x0;
+  // A push is writing its value.
+  static const uint64_t k_claimed = 0x1;
+  // The value may be taken.
+  static const uint64_t k_offered = 0x2;
+  // A pop is reading the value.
+  static const uint64_t k_taken = 0x3;
+
+  struct Slot {
+    std::atomic<uint64_t> state {k_empty};
+    T value;
+    // Keeps the states of neighbouring slots on different cache lines.
+    char padding_[CACHE_LINE_SIZE - sizeof(uint64_t)];
+  };
+
+  static uint64_t next_empty(uint64_t state) {
+    return ((state >> 2) + 1) << 2;
+  }
+
+  static size_t thread_slot(size_t active) {
+    if (tl_thread_info == nullptr) {
+      return 0;
+    }
+    return tl_thread_info->get_thread_id() % active;
+  }
+
+  const size_t width_;
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<size_t> active_ {1};
+
+  DISALLOW_COPY_AND_ASSIGN(EliminationArray);
+};  // class EliminationArray
+
+}  // namespace util
+}  // namespace tervel
+
+#endif  // TERVEL_UTIL_ELIMINATION_ARRAY_H_
@@ -0,0 +1,167 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef TERVEL_UTIL_EVENT_COUNT_H_
+#define TERVEL_UTIL_EVENT_COUNT_H_
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+
+#include <linux/futex.h>
+#include <linux/membarrier.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <tervel/util/system.h>
+#include <tervel/util/util.h>
+
+namespace tervel {
+namespace util {
+
+/**
+ * Lets threads sleep until a condition that other threads make true, such as
+ * a buffer no longer being empty, using a Linux futex.
+ *
+ * A waiter calls prepare_wait, checks the condition, and then either calls
+ * cancel_wait or wait with the key prepare_wait returned. A thread that makes
+ * the condition true calls notify afterwards. notify only reads the waiter
+ * count unless a thread is waiting, so it costs a load of a line that is
+ * rarely written.
+ *
+ * A wake up is not lost: either the waiter's check sees the condition, or
+ * notify sees the waiter and changes the key, which makes a wait that has not
+ * started yet return at once. This requires the update that made the
+ * condition true to be sequentially consistent. A notifier whose update is
+ * only a release store calls notifier_barrier between it and notify, and its
+ * waiters call waiter_barrier between prepare_wait and the check.
+ */
+class EventCount {
+ public:
+  EventCount() {}
+
+  /**
+   * Registers the calling thread as a waiter.
+   * @return the key to pass to wait.
+   */
+  uint32_t prepare_wait() {
+    waiters_.fetch_add(1);
+    return key_.load();
+  }
+
+  /**
+   * Unregisters a waiter which found the condition true.
+   */
+  void cancel_wait() {
+    waiters_.fetch_sub(1);
+  }
+
+  /**
+   * Sleeps until notify is called after prepare_wait returned key, or the
+   * timeout expires, and unregisters the waiter. It may also return
+   * spuriously, so the caller must check the condition again.
+   *
+   * @param key: the value returned by prepare_wait
+   * @param timeout: the longest time to sleep, or a negative value to sleep
+   *   until notified.
+   */
+  void wait(uint32_t key, std::chrono::nanoseconds timeout) {
+    struct timespec ts;
+    struct timespec *ts_ptr = nullptr;
+    if (timeout.count() >= 0) {
+      ts.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+      ts.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+      ts_ptr = &ts;
+    }
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&key_),
+          FUTEX_WAIT_PRIVATE, key, ts_ptr, nullptr, 0);
+    waiters_.fetch_sub(1);
+  }
+
+  /**
+   * Orders a notifier's preceding store before its notify. Where the kernel
+   * supports membarrier this is only a compiler barrier, as waiter_barrier
+   * then forces the ordering on the notifier's behalf, so the notifier does
+   * not pay a fence on each update.
+   */
+  static void notifier_barrier() {
+    if (asymmetric_barriers()) {
+      std::atomic_signal_fence(std::memory_order_seq_cst);
+    } else {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+  }
+
+  /**
+   * Orders a waiter's prepare_wait before its check of the condition, and
+   * any notifier's store before its notify, see notifier_barrier.
+   */
+  static void waiter_barrier() {
+#ifdef SYS_membarrier
+    if (asymmetric_barriers() && syscall(SYS_membarrier,
+          MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0) == 0) {
+      return;
+    }
+#endif
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+  /**
+   * Wakes up to count waiting threads, if any thread is waiting.
+   */
+  void notify(int count = INT_MAX) {
+    if (waiters_.load() != 0) {
+      key_.fetch_add(1);
+      syscall(SYS_futex, reinterpret_cast<uint32_t *>(&key_),
+            FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+    }
+  }
+
+ private:
+  /**
+   * @return whether the process is registered for expedited membarrier, in
+   * which case notifier_barrier does not need a fence.
+   */
+  static bool asymmetric_barriers() {
+#ifdef SYS_membarrier
+    static const bool registered = syscall(SYS_membarrier,
+          MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0;
+    return registered;
+#else
+    return false;
+#endif
+  }
+
+  std::atomic<uint32_t> key_ {0};
+  std::atomic<uint32_t> waiters_ {0};
+  char padding_[CACHE_LINE_SIZE - 2 * sizeof(uint32_t)];
+  DISALLOW_COPY_AND_ASSIGN(EventCount);
+};  // class EventCount
+
+}  // namespace util
+}  // namespace tervel
+
+#endif  // TERVEL_UTIL_EVENT_COUNT_H_
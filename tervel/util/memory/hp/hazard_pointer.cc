@@ -99,8 +99,9 @@ void HazardPointer::unwatch(SlotID slot, Element *descr,
   #ifdef TERVEL_MEM_HP_NO_WATCH
     return;
   #endif
-  hazard_pointer->clear_watch(slot);
+  // descr may be freed as soon as the watch is cleared.
   descr->on_unwatch();
+  hazard_pointer->clear_watch(slot);
 }
 
 bool HazardPointer::hasWatch(SlotID slot,
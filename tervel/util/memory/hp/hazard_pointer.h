@@ -55,7 +55,8 @@ class Element;
  */
 class HazardPointer {
  public:
-  enum class SlotID : size_t {SHORTUSE = 0, SHORTUSE2, PROG_ASSUR, END};
+  enum class SlotID : size_t {SHORTUSE = 0, SHORTUSE2, SHORTUSE3, PROG_ASSUR,
+      END};
 
   explicit HazardPointer(int num_threads);
   ~HazardPointer();
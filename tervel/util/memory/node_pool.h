@@ -0,0 +1,167 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef TERVEL_UTIL_MEMORY_NODE_POOL_H_
+#define TERVEL_UTIL_MEMORY_NODE_POOL_H_
+
+#include <new>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include <tervel/util/util.h>
+#include <tervel/util/system.h>
+
+namespace tervel {
+namespace util {
+namespace memory {
+
+/**
+ * Per-thread cache of cache line aligned memory blocks.
+ *
+ * Blocks are grouped by the number of cache lines they span and a freed block
+ * is kept on the freeing thread's list for that size, up to
+ * TERVEL_MEM_NODE_POOL_MAX blocks per size. Since hazard pointer protected
+ * objects are usually freed by a thread other than the one that allocated
+ * them, blocks migrate between threads freely, no block is ever owned by a
+ * particular list.
+ *
+ * Classes route their storage through the pool by overriding operator new and
+ * operator delete, see the HashMap's Node class for an example. The cached
+ * blocks of a thread are returned to the allocator when the thread exits.
+ */
+class NodePool {
+ public:
+  /**
+   * @param bytes: the size of the block
+   * @return a cache line aligned block of at least 'bytes' bytes
+   */
+  static void * allocate(size_t bytes) {
+    const size_t lines = line_count(bytes);
+    if (lines <= kMaxLines) {
+      ThreadCache *cache = local();
+      Block *block = cache->lists[lines].head;
+      if (block != nullptr) {
+        cache->lists[lines].head = block->next;
+        cache->lists[lines].count--;
+        return block;
+      }
+    }
+
+    void *ptr;
+    if (posix_memalign(&ptr, kLineSize, lines * kLineSize) != 0) {
+      throw std::bad_alloc();
+    }
+    return ptr;
+  }
+
+  /**
+   * Returns a block to the calling thread's list or to the allocator if the
+   * list is full.
+   *
+   * @param ptr: a block returned by allocate
+   * @param bytes: the size that was passed to allocate
+   */
+  static void release(void *ptr, size_t bytes) {
+    if (ptr == nullptr) {
+      return;
+    }
+    const size_t lines = line_count(bytes);
+    if (lines <= kMaxLines) {
+      ThreadCache *cache = local();
+      if (!cache->drained &&
+          cache->lists[lines].count < TERVEL_MEM_NODE_POOL_MAX) {
+        Block *block = reinterpret_cast<Block *>(ptr);
+        block->next = cache->lists[lines].head;
+        cache->lists[lines].head = block;
+        cache->lists[lines].count++;
+        return;
+      }
+    }
+    free(ptr);
+  }
+
+ private:
+  static const size_t kLineSize = CACHE_LINE_SIZE;
+  // Blocks larger than this many cache lines are not cached.
+  static const size_t kMaxLines = 32;
+
+  struct Block {
+    Block *next;
+  };
+
+  struct List {
+    Block *head;
+    size_t count;
+  };
+
+  // Plain data so that it remains usable after the thread's destructors run.
+  struct ThreadCache {
+    List lists[kMaxLines + 1];
+    bool drained;
+  };
+
+  /**
+   * Frees the cached blocks of the thread when it exits.
+   */
+  class Drainer {
+   public:
+    explicit Drainer(ThreadCache *cache) : cache_(cache) {}
+    ~Drainer() {
+      cache_->drained = true;
+      for (size_t i = 0; i <= kMaxLines; i++) {
+        while (cache_->lists[i].head != nullptr) {
+          Block *block = cache_->lists[i].head;
+          cache_->lists[i].head = block->next;
+          free(block);
+        }
+        cache_->lists[i].count = 0;
+      }
+    }
+
+   private:
+    ThreadCache * const cache_;
+  };
+
+  static size_t line_count(size_t bytes) {
+    return (bytes + kLineSize - 1) / kLineSize;
+  }
+
+  static ThreadCache * local() {
+    static __thread ThreadCache cache;
+    static thread_local Drainer drainer(&cache);
+    (void)drainer;
+    return &cache;
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(NodePool);
+};
+
+}  // namespace memory
+}  // namespace util
+}  // namespace tervel
+
+#endif  // TERVEL_UTIL_MEMORY_NODE_POOL_H_
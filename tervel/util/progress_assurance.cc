@@ -49,7 +49,7 @@ void ProgressAssurance::p_check_for_announcement(int64_t &help_id) {
         #if tervel_track_helped_announcement == tervel_track_enable
         TERVEL_METRIC(helped_announcement);
         #endif
-        memory::hp::HazardPointer::unwatch(pos);
+        memory::hp::HazardPointer::unwatch(pos, op);
       }
     }
 }
@@ -0,0 +1,181 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 University of Central Florida's Computer Software Engineering
+Scalable & Secure Systems (CSE - S3) Lab
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef TERVEL_UTIL_SHARDED_COUNTER_H_
+#define TERVEL_UTIL_SHARDED_COUNTER_H_
+
+#include <atomic>
+#include <memory>
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <tervel/util/info.h>
+#include <tervel/util/padded_atomic.h>
+#include <tervel/util/thread_context.h>
+#include <tervel/util/util.h>
+
+namespace tervel {
+namespace util {
+
+/**
+ * A counter which is a single atomic variable.
+ *
+ * It provides the same interface as ShardedCounter, see SizeCounter.
+ */
+class AtomicCounter {
+ public:
+  explicit AtomicCounter(int64_t value = 0) : value_(value) {}
+
+  /**
+   * Adds delta to the counter.
+   */
+  void add(int64_t delta) {
+    value_.fetch_add(delta);
+  }
+
+  /**
+   * Adds delta to the counter.
+   * @return the value of the counter prior to the addition.
+   */
+  int64_t fetch_add(int64_t delta) {
+    return value_.fetch_add(delta);
+  }
+
+  /**
+   * @return the value of the counter.
+   */
+  int64_t load() {
+    return value_.load();
+  }
+
+  /**
+   * @return the value of the counter.
+   */
+  int64_t approximate() {
+    return value_.load();
+  }
+
+ private:
+  std::atomic<int64_t> value_;
+  DISALLOW_COPY_AND_ASSIGN(AtomicCounter);
+};  // class AtomicCounter
+
+
+/**
+ * A counter which spreads updates over a set of cache line sized shards to
+ * avoid contention on a single variable.
+ *
+ * Each thread adds to the shard selected by its thread id. Once a shard's
+ * pending amount reaches TERVEL_SHARDED_COUNTER_FLUSH in magnitude it is
+ * moved into a central total, so approximate() only reads the total and is
+ * never off by more than the number of shards times the flush threshold.
+ * load() additionally sums every shard, it is exact when no updates are in
+ * progress.
+ *
+ * fetch_add bypasses the shards and updates the central total, returning its
+ * prior value. It is exact for counters updated only through fetch_add, which
+ * lets an algorithm that derives positions from the counter share it with
+ * one that does not need to.
+ */
+class ShardedCounter {
+ public:
+  explicit ShardedCounter(int64_t value = 0,
+        size_t num_shards = TERVEL_SHARDED_COUNTER_SHARDS)
+    : num_shards_(num_shards)
+    , total_(value)
+    , shards_(new PaddedAtomic<int64_t>[num_shards]) {
+    for (size_t i = 0; i < num_shards_; i++) {
+      shards_[i].store(0);
+    }
+  }
+
+  /**
+   * Adds delta to the calling thread's shard.
+   */
+  void add(int64_t delta) {
+    PaddedAtomic<int64_t> &shard = shards_[shard_id()];
+    int64_t pending = shard.fetch_add(delta, std::memory_order_relaxed) +
+        delta;
+    if (pending >= TERVEL_SHARDED_COUNTER_FLUSH ||
+          pending <= -TERVEL_SHARDED_COUNTER_FLUSH) {
+      pending = shard.exchange(0);
+      total_.fetch_add(pending);
+    }
+  }
+
+  /**
+   * Adds delta to the central total.
+   * @return the central total prior to the addition.
+   */
+  int64_t fetch_add(int64_t delta) {
+    return total_.fetch_add(delta);
+  }
+
+  /**
+   * @return the central total plus the pending amount of every shard.
+   */
+  int64_t load() {
+    int64_t value = total_.load();
+    for (size_t i = 0; i < num_shards_; i++) {
+      value += shards_[i].load(std::memory_order_relaxed);
+    }
+    return value;
+  }
+
+  /**
+   * @return the central total, without the amounts pending in shards.
+   */
+  int64_t approximate() {
+    return total_.load();
+  }
+
+ private:
+  size_t shard_id() {
+    if (tl_thread_info == nullptr) {
+      return 0;
+    }
+    return tl_thread_info->get_thread_id() % num_shards_;
+  }
+
+  const size_t num_shards_;
+  PaddedAtomic<int64_t> total_;
+  std::unique_ptr<PaddedAtomic<int64_t>[]> shards_;
+  DISALLOW_COPY_AND_ASSIGN(ShardedCounter);
+};  // class ShardedCounter
+
+
+/**
+ * The counter containers use to track their size, see TERVEL_SHARDED_SIZE.
+ */
+#ifdef TERVEL_SHARDED_SIZE
+  typedef ShardedCounter SizeCounter;
+#else
+  typedef AtomicCounter SizeCounter;
+#endif
+
+}  // namespace util
+}  // namespace tervel
+
+#endif  // TERVEL_UTIL_SHARDED_COUNTER_H_
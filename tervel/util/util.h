@@ -80,6 +80,97 @@ namespace util {
  #define TERVEL_MEM_RC_MIN_NODES 5
 #endif
 
+// #define TERVEL_MEM_NODE_POOL_MAX
+ // the number of freed blocks of each size a thread's NodePool keeps for
+ // reuse, blocks freed beyond this are returned to the allocator.
+ // Setting it to 0 disables the caching.
+#ifndef TERVEL_MEM_NODE_POOL_MAX
+ #define TERVEL_MEM_NODE_POOL_MAX 256
+#endif
+
+
+// TERVEL Container MACROS:
+
+// #define TERVEL_SHARDED_SIZE
+  // containers track their size with a ShardedCounter instead of a single
+  // atomic variable, see sharded_counter.h
+
+// #define TERVEL_SHARDED_COUNTER_SHARDS
+  // the number of shards a ShardedCounter has by default
+#ifndef TERVEL_SHARDED_COUNTER_SHARDS
+  #define TERVEL_SHARDED_COUNTER_SHARDS 64
+#endif
+
+// #define TERVEL_SHARDED_COUNTER_FLUSH
+  // the amount a ShardedCounter shard accumulates before it is moved into the
+  // counter's total
+#ifndef TERVEL_SHARDED_COUNTER_FLUSH
+  #define TERVEL_SHARDED_COUNTER_FLUSH 64
+#endif
+
+// #define TERVEL_VECTOR_CONTIGUOUS
+  // wf::vector::Vector stores its elements in a single array allocated by its
+  // constructor instead of a series of growing segments, see
+  // contiguous_array.h. The capacity passed to the constructor is then the
+  // most elements the vector can hold.
+
+// #define TERVEL_VECTOR_HUGEPAGE
+  // wf::vector::Vector advises the kernel to back storage of at least 2MB with
+  // huge pages, see vector_array.h
+
+// #define TERVEL_VECTOR_PARALLEL_BLOCK
+  // the number of positions a worker of parallel_for_each or parallel_reduce
+  // takes at a time, see wf/vector/parallel.h
+#ifndef TERVEL_VECTOR_PARALLEL_BLOCK
+  #define TERVEL_VECTOR_PARALLEL_BLOCK (1 << 16)
+#endif
+
+// #define TERVEL_VECTOR_SNAPSHOT_ATTEMPTS
+  // the number of attempts wf::vector::Vector::snapshot makes before it
+  // announces itself, each attempt costs a pass over the vector
+#ifndef TERVEL_VECTOR_SNAPSHOT_ATTEMPTS
+  #define TERVEL_VECTOR_SNAPSHOT_ATTEMPTS 4
+#endif
+
+// #define TERVEL_RINGBUFFER_REMAP
+  // the ring buffer places consecutive sequence ids on different cache lines,
+  // so that threads working on neighbouring positions do not share a line
+
+// #define TERVEL_RINGBUFFER_WAIT_SPIN
+  // the number of times enqueue_wait and dequeue_wait retry before sleeping
+#ifndef TERVEL_RINGBUFFER_WAIT_SPIN
+  #define TERVEL_RINGBUFFER_WAIT_SPIN 128
+#endif
+
+// #define TERVEL_RINGBUFFER_BULK_ATTEMPTS
+  // the number of times enqueue_bulk and dequeue_bulk try to take their range
+  // of sequence ids before they take them one at a time
+#ifndef TERVEL_RINGBUFFER_BULK_ATTEMPTS
+  #define TERVEL_RINGBUFFER_BULK_ATTEMPTS 4
+#endif
+
+// #define TERVEL_STACK_ELIMINATION
+  // wf::Stack and lf::Stack try to exchange values between a push and a pop
+  // after failing to update their head, see util/elimination_array.h
+
+// #define TERVEL_STACK_LF_WAIT_FREE
+  // lf::Stack announces an operation which fails TERVEL_PROG_ASSUR_LIMIT
+  // times, making it wait-free. As every operation must then help announced
+  // ones, it is wf::Stack's algorithm and lf::Stack forwards to a wf::Stack.
+
+// #define TERVEL_ELIMINATION_WIDTH
+  // the most slots an EliminationArray uses
+#ifndef TERVEL_ELIMINATION_WIDTH
+  #define TERVEL_ELIMINATION_WIDTH 16
+#endif
+
+// #define TERVEL_ELIMINATION_SPIN
+  // the number of times a push offering its value checks whether a pop took
+  // it before withdrawing the offer
+#ifndef TERVEL_ELIMINATION_SPIN
+  #define TERVEL_ELIMINATION_SPIN 256
+#endif
+
 
 
 // TERVEL Progress Assurance MACROS: